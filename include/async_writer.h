@@ -0,0 +1,80 @@
+#pragma once
+
+#include "types.h"
+#include "gzip_stream.h"
+#include "memory_accounting.h"
+#include <memory>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Asynchronous multi-buffered file writer
+ * 
+ * Design Principles:
+ * - The producer fills one buffer while a background thread pwrite()s
+ *   the previously submitted ones, so compute and I/O overlap
+ * - Buffers are exchanged by swapping std::string storage, never copied
+ * - The file is preallocated with fallocate() and trimmed on Close()
+ * - Errors from the writer thread are rethrown on the producer side
+ * - Paths ending in ".gz" are gzip-compressed on the writer thread, so
+ *   compression overlaps with the producer's work
+ */
+class AsyncFileWriter {
+private:
+    int fd_{-1};
+    bool seekable_{true};       // False for stdout, pipes and devices: sequential write() instead of pwrite()
+    uint64_t file_offset_{0};
+    std::unique_ptr<GzipEncoder> encoder_;   // Set for .gz output
+    std::string compressed_;                 // Writer-thread scratch for compressed data
+    
+    std::mutex mutex_;
+    std::condition_variable ready_cv_;    // Signals the writer thread
+    std::condition_variable free_cv_;     // Signals the producer
+    std::deque<std::string> pending_;     // Filled buffers, in file order
+    std::vector<std::string> free_;       // Empty buffers with capacity
+    memory_accounting::TrackedBytes pool_bytes_{memory_accounting::Category::Buffers};
+    bool stopping_{false};
+    bool closed_{false};
+    std::exception_ptr error_;
+    std::thread thread_;
+    
+    void Run();
+    void WriteAll(const std::string& buffer);
+    void WriteBytes(const char* data, size_t size);
+    void RethrowError();
+
+public:
+    /**
+     * Open (truncate) the output file and start the writer thread
+     * @param filename Output file path, or "-" for stdout
+     * @param buffer_count Buffers in rotation, including the one being filled (min 2)
+     * @param buffer_size Capacity reserved per buffer
+     * @param preallocate_bytes Bytes to reserve with fallocate() up front (0 = none)
+     */
+    AsyncFileWriter(const std::string& filename, size_t buffer_count, size_t buffer_size,
+                    uint64_t preallocate_bytes = 0);
+    ~AsyncFileWriter();
+    
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+    
+    /**
+     * Queue a filled buffer for writing
+     * 
+     * The buffer's contents are swapped with an empty buffer from the
+     * pool, blocking only if every buffer is still waiting to be written.
+     * @param buffer Filled buffer; empty (with reserved capacity) on return
+     */
+    void Submit(std::string& buffer);
+    
+    /**
+     * Wait until all submitted buffers are written, then close the file
+     * @throws std::runtime_error if a write, the final truncate or close(2) failed
+     */
+    void Close();
+};
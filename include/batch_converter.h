@@ -0,0 +1,92 @@
+#pragma once
+
+#include "mbo_processor.h"
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * One input file of a batch and where its output goes
+ */
+struct BatchJob {
+    std::string input_file;
+    std::string output_file;
+    uint64_t input_bytes{0};
+};
+
+/**
+ * Outcome of one BatchJob
+ */
+struct BatchResult {
+    BatchJob job;
+    uint64_t records_processed{0};
+    uint64_t mbp_records_generated{0};
+    uint64_t elapsed_ns{0};
+    std::string error;   // Empty on success
+    
+    double RecordsPerSecond() const {
+        return elapsed_ns > 0 ? records_processed * 1e9 / elapsed_ns : 0.0;
+    }
+};
+
+/**
+ * Converts many MBO files concurrently, one MBOProcessor per file
+ *
+ * Design Principles:
+ * - Files are independent, so parallelism is per file and needs no locking
+ *   beyond handing out the next job
+ * - Largest-first (LPT) scheduling: workers take files in decreasing size
+ *   order, so the big ones start early and small ones fill in at the end
+ * - A failing file is reported in its result and does not stop the batch
+ */
+class BatchConverter {
+public:
+    /**
+     * Applies the command-line configuration to each file's processor
+     */
+    using Configure = std::function<void(MBOProcessor&)>;
+    
+    /**
+     * @param output_options Output encoding shared by every file
+     * @param configure Called on each processor before its file is processed
+     */
+    BatchConverter(const OutputOptions& output_options, Configure configure);
+    
+    /**
+     * Expand shell-style glob patterns (and plain paths) into an input list
+     * @throws std::runtime_error if a pattern matches no file
+     */
+    static std::vector<std::string> ExpandInputs(const std::vector<std::string>& patterns);
+    
+    /**
+     * Output path in `output_dir` for an input file, e.g. day1.csv -> DIR/day1_mbp.csv
+     */
+    static std::string OutputPath(const std::string& input_file, const std::string& output_dir, OutputFormat format);
+    
+    /**
+     * Build the jobs for a list of inputs, sorted largest first
+     */
+    std::vector<BatchJob> PlanJobs(const std::vector<std::string>& input_files, const std::string& output_dir) const;
+    
+    /**
+     * Run every job on a pool of `threads` workers
+     * @return One result per job, in job order
+     */
+    std::vector<BatchResult> Run(const std::vector<BatchJob>& jobs, unsigned threads) const;
+    
+    /**
+     * Print per-file and overall throughput
+     * @param wall_ns Wall-clock time of the whole batch
+     */
+    static void Report(std::ostream& out, const std::vector<BatchResult>& results, uint64_t wall_ns);
+
+private:
+    OutputOptions output_options_;
+    Configure configure_;
+    
+    /**
+     * Convert one file; errors are captured in the result
+     */
+    BatchResult Convert(const BatchJob& job) const;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "types.h"
+#include <string>
+#include <zlib.h>
+
+/**
+ * Streaming gzip compressor (zlib deflate with a gzip wrapper)
+ */
+class GzipEncoder {
+private:
+    z_stream stream_{};
+    bool finished_{false};
+    
+    void Run(const char* data, size_t size, int flush, std::string& out);
+
+public:
+    explicit GzipEncoder(int level = Z_DEFAULT_COMPRESSION);
+    ~GzipEncoder();
+    
+    GzipEncoder(const GzipEncoder&) = delete;
+    GzipEncoder& operator=(const GzipEncoder&) = delete;
+    
+    /**
+     * Compress a block, appending any produced bytes to out
+     */
+    void Compress(const char* data, size_t size, std::string& out);
+    
+    /**
+     * Flush remaining data and append the gzip trailer
+     */
+    void Finish(std::string& out);
+};
+
+/**
+ * Streaming gzip decompressor; accepts concatenated gzip members
+ */
+class GzipDecoder {
+private:
+    z_stream stream_{};
+    bool member_complete_{true};   // False while inside a gzip member
+
+public:
+    GzipDecoder();
+    ~GzipDecoder();
+    
+    GzipDecoder(const GzipDecoder&) = delete;
+    GzipDecoder& operator=(const GzipDecoder&) = delete;
+    
+    /**
+     * Decompress as much as fits into the output buffer
+     * @param in Compressed input
+     * @param in_size Compressed bytes available
+     * @param consumed Set to the compressed bytes used
+     * @param out Output buffer
+     * @param out_size Output buffer capacity
+     * @return Decompressed bytes written to out
+     * @throws std::runtime_error on corrupt input
+     */
+    size_t Inflate(const char* in, size_t in_size, size_t& consumed, char* out, size_t out_size);
+    
+    /**
+     * True if the input so far ended on a gzip member boundary
+     */
+    bool AtMemberBoundary() const { return member_complete_; }
+};
+
+namespace utils {
+
+/**
+ * Check whether a path selects gzip encoding (".gz" extension)
+ */
+bool IsGzipPath(const std::string& filename);
+
+} // namespace utils
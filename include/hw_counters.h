@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+/**
+ * Events collected by HwCounters
+ *
+ * The hardware events are what data-layout tuning needs; the two software
+ * events are kept alongside so a run still reports something (and the
+ * per-record normalisation can be sanity-checked) on machines without
+ * an exposed PMU, such as most VMs.
+ */
+enum class HwEvent : uint8_t {
+    Cycles,
+    Instructions,
+    BranchMisses,
+    L1DMisses,     // L1 data cache read misses
+    LLCMisses,     // Last-level cache misses
+    TaskClockNs,   // Software: on-CPU time
+    PageFaults,    // Software
+    COUNT
+};
+
+constexpr size_t kHwEventCount = static_cast<size_t>(HwEvent::COUNT);
+
+const char* HwEventName(HwEvent event);
+
+/**
+ * Counter values for every event; entries for events that are not open stay 0
+ */
+struct HwCounts {
+    uint64_t values[kHwEventCount] = {};
+    
+    uint64_t operator[](HwEvent event) const { return values[static_cast<size_t>(event)]; }
+    
+    HwCounts& operator+=(const HwCounts& other) {
+        for (size_t i = 0; i < kHwEventCount; ++i) {
+            values[i] += other.values[i];
+        }
+        return *this;
+    }
+    
+    HwCounts operator-(const HwCounts& other) const {
+        HwCounts delta;
+        for (size_t i = 0; i < kHwEventCount; ++i) {
+            delta.values[i] = values[i] - other.values[i];
+        }
+        return delta;
+    }
+};
+
+/**
+ * perf_event_open(2) counter group for the calling thread
+ *
+ * Design Principles:
+ * - One group, read with a single read(2), so a snapshot of every event
+ *   costs one system call
+ * - User-space only (exclude_kernel), which works at the default
+ *   perf_event_paranoid level of 2
+ * - Each event is optional: events the CPU, hypervisor or kernel refuse
+ *   are skipped, and with none at all Available() is false and Status()
+ *   says why; callers then simply report nothing
+ * - Values are scaled by time_enabled / time_running if the kernel had
+ *   to multiplex the group
+ */
+class HwCounters {
+private:
+    int leader_fd_{-1};
+    int fds_[kHwEventCount];
+    size_t slot_[kHwEventCount];    // Position of each open event in the group read
+    size_t open_count_{0};
+    std::string status_;
+
+public:
+    /**
+     * Open and start the counters for the calling thread
+     */
+    HwCounters();
+    ~HwCounters();
+    
+    HwCounters(const HwCounters&) = delete;
+    HwCounters& operator=(const HwCounters&) = delete;
+    
+    bool Available() const { return open_count_ > 0; }
+    bool IsOpen(HwEvent event) const { return fds_[static_cast<size_t>(event)] >= 0; }
+    
+    /**
+     * Which events are counted, or why none are
+     */
+    const std::string& Status() const { return status_; }
+    
+    /**
+     * Current (cumulative) counts; all zero if unavailable
+     */
+    HwCounts Read() const;
+    
+    /**
+     * Print per-record figures (instructions, cycles, IPC, misses) for a count delta
+     */
+    void Report(std::ostream& out, const std::string& title, const HwCounts& counts, uint64_t records) const;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "types.h"
+#include "gzip_stream.h"
+#include "memory_accounting.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Line-oriented reader over a file descriptor
+ * 
+ * Design Principles:
+ * - Large read(2) calls straight into one buffer, no stdio layer
+ * - Short reads and lines split across reads are stitched transparently
+ * - Returned lines are views into the buffer, valid until the next call
+ * - "-" reads from stdin, so the converter can sit in a shell pipeline
+ * - Paths ending in ".gz" are decompressed on the fly
+ */
+class LineReader {
+private:
+    int fd_{-1};
+    bool owns_fd_{false};
+    using Buffer = std::vector<char, memory_accounting::CountingAllocator<char, memory_accounting::Category::Buffers>>;
+    Buffer buffer_;
+    size_t begin_{0};      // Start of the unread data
+    size_t end_{0};        // End of the valid data
+    bool eof_{false};
+    uint64_t bytes_read_{0};
+    std::function<void()> before_read_;
+    
+    // Compressed input staging for .gz files
+    std::unique_ptr<GzipDecoder> decoder_;
+    Buffer compressed_;
+    size_t compressed_begin_{0};
+    size_t compressed_end_{0};
+    
+    void Fill();
+    size_t ReadRaw(char* dest, size_t capacity);
+
+public:
+    /**
+     * Open a file for reading
+     * @param filename Input path, or "-" for stdin
+     * @param buffer_size Initial read buffer size (grows for longer lines)
+     */
+    explicit LineReader(const std::string& filename, size_t buffer_size = 1024 * 1024);
+    ~LineReader();
+    
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+    
+    /**
+     * Read the next line without its trailing '\n'
+     * @param line Set to the line on success
+     * @return False at end of input
+     */
+    bool ReadLine(std::string_view& line);
+    
+    /**
+     * Register a callback run before each read(2), i.e. whenever the
+     * reader may block waiting for more input
+     */
+    void SetBeforeRead(std::function<void()> callback) { before_read_ = std::move(callback); }
+    
+    /**
+     * Total (compressed) bytes read from the descriptor so far
+     */
+    uint64_t BytesRead() const { return bytes_read_; }
+};
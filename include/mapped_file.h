@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * Read-only memory mapping of a whole file
+ * 
+ * Design Principles:
+ * - One mmap(2) of the file, advised for sequential access
+ * - Contents are exposed as a string_view; no copies are made
+ * - Empty files are valid and map to an empty view
+ */
+class MappedFile {
+private:
+    const char* data_{nullptr};
+    size_t size_{0};
+    
+public:
+    /**
+     * Map the file for reading
+     * @param filename Path of the file to map
+     */
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    std::string_view View() const { return std::string_view(data_, size_); }
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include "mbp_binary.h"
+#include <string>
+
+/**
+ * Binary MBO stream format
+ * 
+ * A 32-byte mbp_binary::FileHeader (magic "MBO1", record_size 56, symbol)
+ * followed by records in the DBN MBO message layout. Used for live
+ * ingestion, where parsing CSV would dominate the per-record latency.
+ */
+namespace mbo_binary {
+
+constexpr char MAGIC[4] = {'M', 'B', 'O', '1'};
+constexpr uint16_t VERSION = 1;
+constexpr uint8_t RTYPE_MBO = 160;
+
+// DBN MboMsg
+struct MBOMsg {
+    mbp_binary::RecordHeader hd;
+    uint64_t order_id;
+    int64_t price;
+    uint32_t size;
+    uint8_t flags;
+    uint8_t channel_id;
+    char action;
+    char side;
+    uint64_t ts_recv;
+    int32_t ts_in_delta;
+    uint32_t sequence;
+};
+static_assert(sizeof(MBOMsg) == 56, "MBOMsg layout changed");
+
+/**
+ * Stream header announcing MBO records for the given symbol
+ */
+mbp_binary::FileHeader MakeHeader(const std::string& symbol);
+
+/**
+ * Check a received stream header and return its symbol
+ * @throws std::runtime_error if the magic or record size does not match
+ */
+std::string CheckHeader(const mbp_binary::FileHeader& header);
+
+/**
+ * Pack an MBO record into the binary layout
+ */
+MBOMsg Encode(const MBORecord& record);
+
+/**
+ * Unpack a binary record into an existing record, reusing its strings
+ */
+void Decode(const MBOMsg& message, const std::string& symbol, MBORecord& record);
+
+} // namespace mbo_binary
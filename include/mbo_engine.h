@@ -0,0 +1,141 @@
+#pragma once
+
+#include "types.h"
+#include "orderbook.h"
+#include "records.h"
+#include <functional>
+#include <string_view>
+
+/**
+ * Non-owning view of an MBO record for push-style callers
+ * 
+ * Text fields only need to stay valid for the duration of the
+ * MBOEngine::OnRecord call they are passed to.
+ */
+struct MBORecordView {
+    std::string_view ts_recv;
+    std::string_view ts_event;
+    uint8_t rtype{0};
+    uint16_t publisher_id{0};
+    uint32_t instrument_id{0};
+    char action{ACTION_NONE};
+    char side{NEUTRAL_SIDE};
+    Price price{kUndefPrice};
+    Size size{0};
+    uint8_t channel_id{0};
+    OrderID order_id{0};
+    uint8_t flags{0};
+    int32_t ts_in_delta{0};
+    Sequence sequence{0};
+    std::string_view symbol;
+    
+    /**
+     * Copy into an owning record, reusing its string capacity
+     */
+    void CopyTo(MBORecord& record) const;
+};
+
+/**
+ * MBO to MBP reconstruction core
+ * 
+ * Design Principles:
+ * - Push API: records go in one at a time, snapshots come out through a callback
+ * - No file I/O or text formatting; MBOProcessor and embedding
+ *   applications decide what to do with each snapshot
+ * - Emission policy (per action, conflated events, visible changes only,
+ *   time buckets) lives here so every front end behaves the same
+ */
+class MBOEngine {
+public:
+    /**
+     * Receives each depth snapshot
+     * @param index Zero-based snapshot number
+     * @param record Snapshot; only valid for the duration of the call
+     * @param changed_levels Visible levels that changed since the previous snapshot
+     */
+    using SnapshotCallback = std::function<void(uint64_t index, const MBPRecord& record, LevelMask changed_levels)>;
+    
+    explicit MBOEngine(SnapshotCallback callback);
+    
+    /**
+     * Apply one record, emitting a snapshot if the emission policy calls for one
+     * @throws std::runtime_error if output validation is on and the snapshot is malformed
+     */
+    void OnRecord(const MBORecord& record);
+    void OnRecord(const MBORecordView& record);
+    
+    /**
+     * Emit any snapshot still pending (the last sampling bucket)
+     */
+    void Finish();
+    
+    /**
+     * Configuration; see the matching MBOProcessor setters
+     */
+    void SetValidateOutput(bool validate) { validate_output_ = validate; }
+    void SetConflateEvents(bool conflate) { conflate_events_ = conflate; }
+    void SetVisibleChangesOnly(bool enable) { visible_changes_only_ = enable; }
+    void SetSampleInterval(uint64_t interval_ns, bool fill_empty_buckets = false) {
+        sample_interval_ns_ = interval_ns;
+        fill_empty_buckets_ = fill_empty_buckets;
+    }
+    
+    const OrderBook& Book() const { return order_book_; }
+    uint64_t RecordCount() const { return record_count_; }
+    uint64_t SnapshotCount() const { return snapshot_count_; }
+    uint64_t SuppressedCount() const { return suppressed_count_; }
+
+private:
+    OrderBook order_book_;
+    SnapshotCallback callback_;
+    MBORecord view_record_;   // Scratch record for OnRecord(const MBORecordView&)
+    uint64_t record_count_{0};
+    uint64_t snapshot_count_{0};
+    uint64_t suppressed_count_{0};  // Snapshots skipped for having no visible change
+    
+    // Configuration
+    bool validate_output_{true};
+    bool conflate_events_{false};       // Emit one snapshot per F_LAST-terminated event
+    bool visible_changes_only_{false};  // Skip snapshots whose top-N levels did not change
+    
+    // Time-bucketed sampling (sample_interval_ns_ == 0 disables it)
+    uint64_t sample_interval_ns_{0};
+    bool fill_empty_buckets_{false};
+    bool has_sample_record_{false};
+    uint64_t current_bucket_{0};
+    MBORecord last_sample_record_;   // Metadata source for the pending bucket's snapshot
+    MBPRecord sample_row_;           // Snapshot of the bucket being closed
+    
+    /**
+     * Validate a snapshot and hand it to the callback with the changed levels
+     */
+    void EmitSnapshot(const MBPRecord& record);
+    void EmitSnapshot(const MBPRecord& record, LevelMask changed_levels);
+    
+    /**
+     * Create MBP record from current order book state
+     */
+    MBPRecord CreateMBPRecord(const MBORecord& mbo_record);
+    
+    /**
+     * Validate MBP record before emitting
+     */
+    void ValidateMBPRecord(const MBPRecord& record) const;
+    
+    /**
+     * Apply a record in sampling mode, emitting snapshots for completed buckets
+     */
+    void SampleRecord(const MBORecord& record);
+    
+    /**
+     * Emit sample_row_ for the pending bucket (and carried-forward empty buckets)
+     * @param next_bucket First bucket that is not complete yet
+     * @param changed_levels Levels changed since the previous row
+     */
+    void EmitSampleRows(uint64_t next_bucket, LevelMask changed_levels);
+    
+    /**
+     * Emit sample_row_ labeled with the end of the given bucket
+     */
+    void WriteSampleRow(uint64_t bucket, LevelMask changed_levels);
+};
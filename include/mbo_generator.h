@@ -0,0 +1,159 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * How generated order IDs are assigned
+ */
+enum class OrderIdPattern : uint8_t {
+    Sequential,   // 1, 2, 3, ...
+    Random,       // Unique but scattered over 63 bits (hash-unfriendly key order)
+    Recycled      // IDs of cancelled orders are reused first (lookup erase/insert churn)
+};
+
+/**
+ * Parse "sequential", "random" or "recycled"
+ * @throws std::invalid_argument for anything else
+ */
+OrderIdPattern ParseOrderIdPattern(const std::string& name);
+
+/**
+ * Synthetic MBO stream parameters; the defaults resemble data/mbo.csv
+ */
+struct GeneratorConfig {
+    uint64_t records{1000000};             // Records after the leading clear records
+    uint32_t instruments{1};
+    uint32_t first_instrument_id{1108};
+    std::string symbol{"SYN"};             // Instruments after the first get SYN1, SYN2, ...
+    
+    // Relative weights of the record types (trades also emit the fill and cancel)
+    double add_weight{0.50};
+    double cancel_weight{0.40};
+    double modify_weight{0.05};
+    double trade_weight{0.05};
+    
+    // Prices: the mid follows a random walk; new orders rest within `depth` ticks of it
+    Price start_price{5510000000};         // 5.51
+    Price tick_size{10000000};             // 0.01
+    double walk_probability{0.01};         // Per event chance the mid moves one tick
+    uint32_t depth{20};
+    uint32_t target_orders{2000};          // Cap on resting orders per instrument; adds beyond it become cancels
+    Size max_size{500};
+    OrderIdPattern order_ids{OrderIdPattern::Sequential};
+    
+    // Timing: events are groups of records sharing ts_event (F_LAST on the last one)
+    Timestamp start_time_ns{1752739200000000000ULL};   // 2025-07-17T08:00:00Z
+    uint64_t mean_gap_ns{50000};           // Mean time between events
+    double mean_event_records{1.5};        // Mean records per event (geometric)
+    double burst_probability{0.001};       // Per event chance that a burst starts
+    uint32_t burst_events{200};            // Events in a burst
+    uint32_t burst_speedup{100};           // Gap divisor inside a burst
+    
+    uint64_t seed{1};
+    
+    /**
+     * @throws std::invalid_argument if a parameter is out of range
+     */
+    void Validate() const;
+};
+
+/**
+ * Seeded generator of realistic MBO record streams
+ *
+ * Design Principles:
+ * - Streams, never materialises: memory is O(resting orders), so the record
+ *   count is only bounded by time
+ * - Every cancel, modify and fill refers to a resting order, and the book
+ *   never crosses: when the mid walks into resting orders they are traded
+ *   away (trade, fill, cancel) in the same event
+ * - Fully determined by the config (including the seed), so a failing run can
+ *   be reproduced from its command line
+ */
+class MBOGenerator {
+private:
+    struct RestingOrder {
+        OrderID id;
+        Price price;
+        Size size;
+        char side;
+    };
+    
+    struct Instrument {
+        uint32_t instrument_id;
+        std::string symbol;
+        Price mid;
+        std::vector<RestingOrder> orders;
+    };
+    
+    GeneratorConfig config_;
+    std::mt19937_64 rng_;
+    std::vector<Instrument> instruments_;
+    std::deque<MBORecord> pending_;        // Records of the current event not yet returned
+    std::vector<OrderID> free_ids_;        // Recycled pattern only
+    uint64_t next_id_{1};
+    uint64_t generated_{0};
+    uint64_t remaining_;                   // Book records still to be generated
+    uint64_t clears_left_;
+    Sequence sequence_{0};
+    Timestamp ts_event_;
+    uint32_t burst_events_left_{0};
+    double total_weight_;
+    
+    void GenerateEvent();
+    void AddOrder(Instrument& instrument, std::vector<MBORecord>& event);
+    void CancelOrder(Instrument& instrument, std::vector<MBORecord>& event);
+    void ModifyOrder(Instrument& instrument, std::vector<MBORecord>& event);
+    void TradeAtTouch(Instrument& instrument, std::vector<MBORecord>& event);
+    void MoveMid(Instrument& instrument, std::vector<MBORecord>& event);
+    void Fill(Instrument& instrument, size_t index, std::vector<MBORecord>& event);
+    void RemoveOrder(Instrument& instrument, size_t index);
+    OrderID NewOrderId();
+    MBORecord MakeRecord(const Instrument& instrument, char action, char side, Price price, Size size, OrderID order_id);
+    Price RandomPrice(const Instrument& instrument, char side);
+    Size RandomSize();
+    uint64_t Uniform(uint64_t bound) { return rng_() % bound; }
+    
+    // Own [0, 1) mapping: std distributions differ between standard libraries
+    double UniformReal() { return static_cast<double>(rng_() >> 11) * 0x1.0p-53; }
+
+public:
+    explicit MBOGenerator(const GeneratorConfig& config);
+    
+    /**
+     * Produce the next record: one clear record per instrument, then
+     * config.records book records
+     * @return false once the stream is complete
+     */
+    bool Next(MBORecord& record);
+    
+    /**
+     * Records returned so far, including the clear records
+     */
+    uint64_t Generated() const { return generated_; }
+    
+    /**
+     * Resting orders across all instruments
+     */
+    size_t RestingOrders() const;
+};
+
+namespace mbo_generator {
+
+/**
+ * CSV header line of the MBO input format (without newline)
+ */
+extern const char* const kCSVHeader;
+
+/**
+ * Append a record as one CSV line in the input format (prices with 9
+ * decimals, empty price for clear records), including the newline
+ */
+void AppendCSV(const MBORecord& record, std::string& out);
+
+} // namespace mbo_generator
@@ -1,68 +1,151 @@
 #pragma once
 
 #include "types.h"
-#include "orderbook.h"
+#include "mbo_engine.h"
+#include "mbo_stream.h"
+#include "shm_book.h"
 #include "records.h"
+#include "mbp_formatter.h"
+#include "mbp_sink.h"
+#include "async_writer.h"
+#include "hw_counters.h"
+#include "memory_accounting.h"
+#include "parallel_formatter.h"
+#include "run_metrics.h"
 #include "utils.h"
+#include <atomic>
 #include <fstream>
 #include <string>
 #include <memory>
+#include <chrono>
+#include <iostream>
 
 /**
  * Main processor for converting MBO data to MBP format
  * 
  * Design Principles:
- * - Single responsibility: Process MBO records and generate MBP output
+ * - Thin file front end: reads MBO input, feeds MBOEngine, writes its snapshots
  * - Performance optimization: Buffered I/O, change tracking
  * - Error handling: Robust error handling and validation
  * - Memory efficiency: Minimal allocations during processing
  */
 class MBOProcessor {
 private:
-    OrderBook order_book_;
+    MBOEngine engine_;
     std::ofstream output_file_;
+    std::unique_ptr<AsyncFileWriter> async_writer_;  // Replaces output_file_ when async I/O is on
+    bool output_to_stdout_{false};                   // Synchronous writes straight to fd 1
     std::string output_buffer_;
-    uint64_t record_count_{0};
-    uint64_t mbp_record_count_{0};
+    memory_accounting::TrackedBytes output_buffer_bytes_{memory_accounting::Category::Buffers};
+    size_t output_buffer_size_;
+    MBPRowFormatter row_formatter_;
+    std::unique_ptr<ParallelRowFormatter> parallel_formatter_;  // Set when formatting on worker threads
+    std::unique_ptr<MBPSink> sink_;  // Set for non-CSV output formats
     utils::PerformanceMonitor performance_monitor_;
+    std::ostream* report_stream_{&std::cout};  // stderr when the data goes to stdout
+    
+    // Shared-memory book publishing (optional, alongside the regular output);
+    // the engine keeps one book, so only the first instrument seen is accepted
+    std::unique_ptr<ShmBookPublisher> shm_publisher_;
+    uint32_t shm_instrument_id_{0};
+    bool shm_instrument_known_{false};
+    
+    // RSS sampling thread, running while a monitored run is in progress
+    std::unique_ptr<memory_accounting::RssSampler> rss_sampler_;
+    
+    // Stage breakdown JSON written on close (empty = none)
+    std::string stage_report_file_;
+    
+    // perf_event counters on the book thread (optional)
+    bool hw_counters_enabled_{false};
+    std::unique_ptr<HwCounters> hw_counters_;
+    HwCounts hw_start_;
+    HwCounts hw_total_;
+    
+    // Receive-to-output latency of rows published in streaming mode
+    utils::LatencyHistogram stream_latency_;
+    
+    // Metrics files rewritten during the run (optional) and their inputs
+    std::unique_ptr<MetricsExporter> metrics_exporter_;
+    std::string output_filename_;
+    uint64_t records_rejected_{0};
+    uint64_t bytes_in_{0};
+    std::atomic<uint64_t> bytes_out_{0};   // Added by whichever thread writes chunks
+    uint64_t metrics_polls_{0};
+    
+    // Latency bound for buffered output (0 = flush only when buffers fill)
+    uint64_t flush_interval_ns_{0};
+    std::chrono::steady_clock::time_point last_flush_time_;
     
     // Configuration
     bool skip_first_record_{true};  // Skip the initial clear record
-    bool validate_output_{true};    // Validate output format
     bool enable_performance_monitoring_{true};
+    bool visible_changes_only_{false};  // Report suppressed rows in the final stats
+    bool closed_{false};
     
-    // Buffering for performance
-    static constexpr size_t OUTPUT_BUFFER_SIZE = 64 * 1024;  // 64KB
+    // Rows per chunk handed to formatting worker threads
+    static constexpr size_t PARALLEL_FORMAT_BATCH_ROWS = 512;
+    
+    // Records between checks of the metrics interval (power of two)
+    static constexpr uint64_t METRICS_POLL_RECORDS = 1024;
 
 public:
     /**
      * Constructor
-     * @param output_filename Output MBP file path
+     * @param output_filename Output MBP file path, or "-" for stdout (CSV only)
+     * @param output_options Output encoding (CSV by default) and its settings
      */
-    explicit MBOProcessor(const std::string& output_filename);
+    explicit MBOProcessor(const std::string& output_filename, const OutputOptions& output_options = OutputOptions());
     
     /**
-     * Destructor - ensures proper cleanup
+     * Destructor - closes the output if Close() was not called, reporting
+     * rather than throwing any error
      */
     ~MBOProcessor();
     
     /**
      * Process MBO file and generate MBP output
-     * @param input_filename Input MBO file path
+     * @param input_filename Input MBO file path, or "-" for stdin
      */
     void ProcessFile(const std::string& input_filename);
     
+    /**
+     * Process records from a live source until the writer closes it
+     * 
+     * Every row is flushed as soon as it is produced, and the time from
+     * receiving the record to handing its row to the output is recorded.
+     * @param source "unix:/path" to listen on a socket, or a FIFO path
+     * @param options Framing and polling mode
+     */
+    void ProcessStream(const std::string& source, const StreamOptions& options);
+    
+    /**
+     * Emit pending rows, flush and close the output
+     * 
+     * Call once processing is done so that write errors reach the caller;
+     * later calls do nothing.
+     * @throws std::runtime_error if the output cannot be written or closed
+     */
+    void Close();
+    
     /**
      * Process a single MBO record
      * @param record The MBO record to process
+     * @throws std::invalid_argument for a second instrument while publishing
+     *         to shared memory
      */
     void ProcessRecord(const MBORecord& record);
     
     /**
-     * Write MBP record to output
+     * Write an MBP snapshot from the engine to output
+     * 
+     * Only the levels the order book flagged as changed since the previous
+     * row are re-rendered; the rest reuse the previous row's text.
+     * @param index Row index
      * @param record The MBP record to write
+     * @param changed_levels Visible levels changed since the previous row
      */
-    void WriteMBPRecord(const MBPRecord& record);
+    void WriteMBPRecord(uint64_t index, const MBPRecord& record, LevelMask changed_levels);
     
     /**
      * Write CSV header to output file
@@ -71,6 +154,10 @@ public:
     
     /**
      * Flush output buffer to file
+     * 
+     * With async I/O the buffer is handed to the writer thread and a
+     * fresh one is taken from the pool; the call only blocks if every
+     * buffer is still queued.
      */
     void FlushOutput();
     
@@ -80,6 +167,8 @@ public:
     struct ProcessingStats {
         uint64_t records_processed;
         uint64_t mbp_records_generated;
+        uint64_t mbp_records_suppressed;
+        uint64_t records_rejected;
         uint64_t processing_time_ms;
         double records_per_second;
     };
@@ -89,8 +178,81 @@ public:
      * Set configuration options
      */
     void SetSkipFirstRecord(bool skip) { skip_first_record_ = skip; }
-    void SetValidateOutput(bool validate) { validate_output_ = validate; }
+    void SetValidateOutput(bool validate) { engine_.SetValidateOutput(validate); }
     void SetPerformanceMonitoring(bool enable) { enable_performance_monitoring_ = enable; }
+    
+    /**
+     * Apply every record of an event but emit a single MBP row when the
+     * record carrying F_LAST arrives (if the book changed during the event)
+     */
+    void SetConflateEvents(bool conflate) { engine_.SetConflateEvents(conflate); }
+    
+    /**
+     * Bound how long a written row may sit in output buffers; buffers are
+     * also flushed whenever the input reader is about to block
+     * @param interval_ns Maximum buffering delay in nanoseconds (0 = no bound)
+     */
+    void SetFlushInterval(uint64_t interval_ns) { flush_interval_ns_ = interval_ns; }
+    
+    /**
+     * Also publish every snapshot into a shared-memory region readable
+     * with ShmBookReader; records of any instrument other than the first
+     * are then rejected, since they would land in the same book
+     * @param name Segment name (e.g. "mbp_book" for /dev/shm/mbp_book)
+     */
+    void SetShmPublisher(const std::string& name) { shm_publisher_ = std::make_unique<ShmBookPublisher>(name); }
+    
+    /**
+     * Stream for the final statistics report (stdout by default)
+     */
+    void SetReportStream(std::ostream& stream) { report_stream_ = &stream; }
+    
+    /**
+     * Write the per-stage cycle breakdown as JSON when the processor closes
+     * (only populated in builds with STAGE_TIMERS=1)
+     */
+    void SetStageReportFile(const std::string& filename) { stage_report_file_ = filename; }
+    
+    /**
+     * Count cycles, instructions, branch and cache misses on the book thread
+     * and report them per record (per stage too with STAGE_TIMERS=1)
+     */
+    void SetHwCounters(bool enable) { hw_counters_enabled_ = enable; }
+    
+    /**
+     * Export run metrics to the given files (".prom" = Prometheus textfile,
+     * otherwise JSON), rewritten every interval and once more at the end.
+     * Writes an initial snapshot right away, so bad paths fail up front;
+     * later write failures are logged once and counted, never thrown.
+     * @throws std::runtime_error if the initial snapshot cannot be written
+     */
+    void SetMetricsOutput(const std::vector<std::string>& paths, uint64_t interval_ns);
+    
+    /**
+     * Current metrics snapshot
+     * @param complete Whether the run has finished (includes every thread's stage totals)
+     */
+    RunMetrics CollectMetrics(bool complete) const;
+    
+    /**
+     * Suppress rows when the book changed only below the visible depth,
+     * i.e. when the row's level columns would repeat the previous row
+     */
+    void SetVisibleChangesOnly(bool enable) {
+        visible_changes_only_ = enable;
+        engine_.SetVisibleChangesOnly(enable);
+    }
+    
+    /**
+     * Apply every record but emit a snapshot only when ts_event crosses a
+     * bucket boundary. The row carries the bucket's last record with
+     * ts_event set to the bucket end.
+     * @param interval_ns Bucket width in nanoseconds (0 disables sampling)
+     * @param fill_empty_buckets Repeat the last snapshot for buckets without records
+     */
+    void SetSampleInterval(uint64_t interval_ns, bool fill_empty_buckets = false) {
+        engine_.SetSampleInterval(interval_ns, fill_empty_buckets);
+    }
 
 private:
     /**
@@ -99,29 +261,35 @@ private:
     void InitializeOutput();
     
     /**
-     * Create MBP record from current order book state
-     * @param mbo_record The original MBO record
-     * @return MBP record with current order book state
+     * Flush buffered output if the flush interval has elapsed
+     */
+    void FlushIfDue();
+    
+    /**
+     * Write a formatted chunk of CSV rows to the output file
+     * @param chunk Rows to write; may be swapped for an empty buffer
+     */
+    void WriteChunk(std::string& chunk);
+    
+    /**
+     * Start sampling RSS in the background if monitoring is on
      */
-    MBPRecord CreateMBPRecord(const MBORecord& mbo_record);
+    void StartRssSampling();
     
     /**
-     * Validate MBP record before writing
-     * @param record The MBP record to validate
+     * Open the counter group on the calling (book) thread if requested
      */
-    void ValidateMBPRecord(const MBPRecord& record) const;
+    void StartHwCounters();
     
     /**
-     * Handle special cases (like initial clear record)
-     * @param record The MBO record to check
-     * @return True if this is a special case that should be handled differently
+     * Accumulate the counts since StartHwCounters() and detach the group
      */
-    bool HandleSpecialCase(const MBORecord& record);
+    void StopHwCounters();
     
     /**
-     * Update performance monitoring
+     * Note the input position and rewrite the metrics files if the interval elapsed
      */
-    void UpdatePerformanceStats();
+    void PollMetrics(uint64_t bytes_in);
     
     /**
      * Report final statistics
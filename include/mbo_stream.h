@@ -0,0 +1,108 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Record framing on a live MBO stream
+ */
+enum class StreamFraming {
+    CSV,      // Newline-terminated MBO CSV lines, optionally preceded by the header
+    Binary    // mbo_binary stream header followed by 56-byte MBO messages
+};
+
+/**
+ * Outcome of reading one record from a live stream
+ */
+enum class StreamStatus {
+    Record,      // The record was decoded
+    Malformed,   // A CSV line failed to parse; Error() says why and reading can continue
+    End          // The writer has closed the stream
+};
+
+/**
+ * Options for live ingestion
+ */
+struct StreamOptions {
+    StreamFraming framing{StreamFraming::CSV};
+    bool busy_poll{false};          // Spin on a non-blocking descriptor instead of sleeping in read(2)
+    size_t buffer_size{64 * 1024};
+};
+
+/**
+ * Reader for MBO records arriving on a Unix domain socket or FIFO
+ * 
+ * Design Principles:
+ * - "unix:/path" listens on a stream socket and serves the first
+ *   connection; any other path (a FIFO, or stdin as "-") is read as is
+ * - Records are decoded as soon as their last byte arrives; nothing
+ *   waits for a buffer to fill
+ * - Each record carries the monotonic time of the read that completed
+ *   it, for receive-to-output latency measurements
+ */
+class MBOStreamReader {
+private:
+    int fd_{-1};
+    int listen_fd_{-1};
+    bool owns_fd_{false};
+    int saved_flags_{-1};            // File status flags before --busy-poll, restored on close
+    std::string socket_path_;
+    StreamOptions options_;
+    std::vector<char> buffer_;
+    size_t begin_{0};
+    size_t end_{0};
+    bool eof_{false};
+    bool header_checked_{false};
+    std::string symbol_;             // From the binary stream header
+    uint64_t receive_time_{0};       // MonotonicNanos() of the latest successful read
+    uint64_t record_receive_time_{0};
+    uint64_t bytes_read_{0};
+    std::string error_;              // Why the last CSV line was rejected
+    
+    bool Fill();
+    StreamStatus NextCSV(MBORecord& record);
+    StreamStatus NextBinary(MBORecord& record);
+    void OpenSocket(const std::string& path);
+
+public:
+    /**
+     * Open the source; for sockets this blocks until a client connects
+     * @throws std::runtime_error if the source cannot be opened
+     */
+    MBOStreamReader(const std::string& source, const StreamOptions& options);
+    ~MBOStreamReader();
+    
+    MBOStreamReader(const MBOStreamReader&) = delete;
+    MBOStreamReader& operator=(const MBOStreamReader&) = delete;
+    
+    /**
+     * Read the next record, blocking (or spinning) until one is complete
+     * @return Malformed for a CSV line that does not parse (the line is
+     *         consumed), End once the writer has closed the stream
+     * @throws std::runtime_error on read errors or a malformed binary stream
+     */
+    StreamStatus Next(MBORecord& record);
+    
+    /**
+     * Parse error of the line behind the last Malformed status
+     */
+    const std::string& Error() const { return error_; }
+    
+    /**
+     * MonotonicNanos() at which the last returned record was received
+     */
+    uint64_t ReceiveTime() const { return record_receive_time_; }
+    
+    /**
+     * Total bytes read from the source so far
+     */
+    uint64_t BytesRead() const { return bytes_read_; }
+    
+    /**
+     * Whether a path names a live source ("unix:" socket or FIFO)
+     */
+    static bool IsStreamSource(const std::string& source);
+};
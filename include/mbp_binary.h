@@ -0,0 +1,134 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include "mbp_sink.h"
+#include <fstream>
+#include <string>
+
+/**
+ * Binary MBP-10 file format
+ * 
+ * A 32-byte file header followed by an array of fixed-size records that
+ * use the DBN MBP-10 message layout. All integers are little-endian, so
+ * row N lives at offset sizeof(MBPFileHeader) + N * sizeof(MBP10Record).
+ */
+namespace mbp_binary {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Binary MBP-10 records are written in host byte order");
+
+constexpr char MAGIC[4] = {'M', 'B', '1', '0'};
+constexpr uint16_t VERSION = 1;
+constexpr uint8_t RTYPE_MBP10 = 10;
+
+struct FileHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;
+    uint64_t record_count;   // Patched on close; derive from file size if 0
+    char symbol[16];         // NUL-padded symbol of the first record
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader layout changed");
+
+// DBN RecordHeader
+struct RecordHeader {
+    uint8_t length;          // Record length in 4-byte units
+    uint8_t rtype;
+    uint16_t publisher_id;
+    uint32_t instrument_id;
+    uint64_t ts_event;       // Nanoseconds since UNIX epoch
+};
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader layout changed");
+
+// DBN BidAskPair
+struct BidAskPair {
+    int64_t bid_px;
+    int64_t ask_px;
+    uint32_t bid_sz;
+    uint32_t ask_sz;
+    uint32_t bid_ct;
+    uint32_t ask_ct;
+};
+static_assert(sizeof(BidAskPair) == 32, "BidAskPair layout changed");
+
+// DBN Mbp10Msg
+struct MBP10Record {
+    RecordHeader hd;
+    int64_t price;
+    uint32_t size;
+    char action;
+    char side;
+    uint8_t flags;
+    uint8_t depth;
+    uint64_t ts_recv;
+    int32_t ts_in_delta;
+    uint32_t sequence;
+    BidAskPair levels[MBP_LEVELS];
+};
+static_assert(sizeof(MBP10Record) == 368, "MBP10Record layout changed");
+
+/**
+ * Pack an MBP record into the binary layout
+ */
+MBP10Record Encode(const MBPRecord& record);
+
+/**
+ * Unpack a binary record (order_id is not part of the layout and is 0)
+ */
+MBPRecord Decode(const MBP10Record& record, const std::string& symbol);
+
+} // namespace mbp_binary
+
+/**
+ * Writes MBP records as a binary MBP-10 file
+ */
+class MBPBinaryWriter : public MBPSink {
+private:
+    std::ofstream file_;
+    std::string buffer_;
+    mbp_binary::FileHeader header_{};
+    bool closed_{false};
+
+public:
+    explicit MBPBinaryWriter(const std::string& filename);
+    ~MBPBinaryWriter() override;
+    
+    void Write(uint64_t index, const MBPRecord& record, LevelMask changed) override;
+    void Flush() override;
+    void Close() override;
+};
+
+/**
+ * Random-access reader for binary MBP-10 files
+ */
+class MBPBinaryReader {
+private:
+    mutable std::ifstream file_;
+    mbp_binary::FileHeader header_{};
+    uint64_t record_count_{0};
+
+public:
+    explicit MBPBinaryReader(const std::string& filename);
+    
+    /**
+     * Number of records in the file
+     */
+    uint64_t RecordCount() const { return record_count_; }
+    
+    /**
+     * Symbol recorded in the file header
+     */
+    std::string Symbol() const;
+    
+    /**
+     * Read the record at the given row in O(1)
+     * @throws std::out_of_range if row >= RecordCount()
+     */
+    mbp_binary::MBP10Record ReadRaw(uint64_t row) const;
+    
+    /**
+     * Read and decode the record at the given row
+     */
+    MBPRecord Read(uint64_t row) const;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include "mbp_sink.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Columnar MBP file format
+ * 
+ * Rows are buffered into row groups; within a group every column is
+ * written contiguously with its own encoding:
+ * - DELTA: zigzag varint of the difference to the previous value
+ *   (timestamps, prices, sequence, order_id)
+ * - RLE:   (zigzag varint value, varint run length) pairs
+ *   (sizes, counts and low-cardinality fields)
+ * - PLAIN: zigzag varint per value
+ * 
+ * File layout: "MBPC" + version, row group column chunks, footer
+ * (schema, symbol dictionary, per row group column offsets, null
+ * counts and min/max stats), then the footer offset and a trailing "MBPC".
+ */
+namespace mbp_columnar {
+
+constexpr char MAGIC[4] = {'M', 'B', 'P', 'C'};
+constexpr uint16_t VERSION = 2;
+constexpr size_t DEFAULT_ROW_GROUP_SIZE = 64 * 1024;
+
+enum class Encoding : uint8_t {
+    Plain = 0,
+    Delta = 1,
+    RLE = 2
+};
+
+// How a column's integer values map back to MBP fields
+enum class ColumnKind : uint8_t {
+    Integer = 0,
+    Price = 1,      // 1e-9 fixed point, kUndefPrice for empty
+    Timestamp = 2,  // Nanoseconds since the UNIX epoch
+    Char = 3,       // Single character (action, side)
+    Symbol = 4      // Index into the file's symbol dictionary
+};
+
+struct ColumnInfo {
+    std::string name;
+    Encoding encoding;
+    ColumnKind kind;
+};
+
+struct ColumnChunk {
+    uint64_t offset;
+    uint64_t length;
+    uint64_t null_count;   // Empty levels (kUndefPrice) in price columns
+    int64_t min_value;     // Over non-null values; kUndefPrice if all are null
+    int64_t max_value;
+};
+
+struct RowGroup {
+    uint64_t row_count;
+    std::vector<ColumnChunk> columns;
+};
+
+/**
+ * The fixed schema of a columnar MBP file, in CSV column order
+ */
+const std::vector<ColumnInfo>& Schema();
+
+/**
+ * Encode values with the given encoding, appending to out
+ */
+void EncodeColumn(Encoding encoding, const std::vector<int64_t>& values, std::string& out);
+
+/**
+ * Decode row_count values from data, appending to out
+ * @throws std::runtime_error on truncated input
+ */
+void DecodeColumn(Encoding encoding, const char* data, size_t length, uint64_t row_count, std::vector<int64_t>& out);
+
+} // namespace mbp_columnar
+
+/**
+ * Writes MBP records as a columnar file
+ */
+class MBPColumnarWriter : public MBPSink {
+private:
+    std::ofstream file_;
+    uint64_t file_offset_{0};
+    size_t row_group_size_;
+    std::vector<std::vector<int64_t>> columns_;
+    std::vector<mbp_columnar::RowGroup> row_groups_;
+    std::vector<std::string> symbols_;
+    std::string encode_buffer_;
+    bool closed_{false};
+    
+    void AppendBytes(const std::string& bytes);
+    void WriteRowGroup();
+    void WriteFooter();
+    int64_t SymbolIndex(const std::string& symbol);
+
+public:
+    explicit MBPColumnarWriter(const std::string& filename,
+                               size_t row_group_size = mbp_columnar::DEFAULT_ROW_GROUP_SIZE);
+    ~MBPColumnarWriter() override;
+    
+    void Write(uint64_t index, const MBPRecord& record, LevelMask changed) override;
+    void Flush() override;
+    void Close() override;
+};
+
+/**
+ * Reader that materializes only the requested columns of a columnar file
+ */
+class MBPColumnarReader {
+private:
+    mutable std::ifstream file_;
+    std::vector<mbp_columnar::RowGroup> row_groups_;
+    std::vector<std::string> symbols_;
+    uint64_t row_count_{0};
+
+public:
+    /**
+     * @throws std::runtime_error if the file is not a columnar MBP file of this version
+     */
+    explicit MBPColumnarReader(const std::string& filename);
+    
+    uint64_t RowCount() const { return row_count_; }
+    const std::vector<mbp_columnar::RowGroup>& RowGroups() const { return row_groups_; }
+    const std::vector<std::string>& Symbols() const { return symbols_; }
+    
+    /**
+     * Position of a column in the schema
+     * @throws std::invalid_argument for unknown column names
+     */
+    static size_t ColumnIndex(const std::string& name);
+    
+    /**
+     * Read whole columns, touching only their chunks in each row group
+     * @param names Column names as in the CSV header (e.g. "bid_px_00")
+     * @return One vector of RowCount() values per requested column
+     */
+    std::vector<std::vector<int64_t>> ReadColumns(const std::vector<std::string>& names) const;
+};
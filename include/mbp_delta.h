@@ -0,0 +1,75 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include "mbp_sink.h"
+#include "line_reader.h"
+#include <array>
+#include <fstream>
+#include <string>
+
+/**
+ * Incremental (delta) MBP update stream
+ * 
+ * One line per MBP event:
+ *   index,ts_event,action,side,price,size,flags,sequence,order_id,type,levels
+ * where type is 'S' for a full snapshot of all visible levels (emitted
+ * every snapshot_interval rows for resync) or 'U' for an update, and
+ * levels is a '|' separated list of side:level_index:price:size:count
+ * tuples. Updates only carry the levels that changed since the previous
+ * line; an empty price means the level is now empty.
+ */
+class MBPDeltaWriter : public MBPSink {
+private:
+    std::ofstream file_;
+    std::string buffer_;
+    uint32_t snapshot_interval_;
+    uint64_t rows_since_snapshot_{0};
+    bool has_snapshot_{false};
+    
+    // Last written state, in LevelMask bit order (bids then asks)
+    std::array<CompactPriceLevel, 2 * MBP_LEVELS> levels_;
+    
+    void AppendLevel(char side, int level, const CompactPriceLevel& values, bool& first);
+
+public:
+    /**
+     * @param filename Output file path
+     * @param snapshot_interval Rows between full snapshots (0 = first row only)
+     */
+    MBPDeltaWriter(const std::string& filename, uint32_t snapshot_interval);
+    ~MBPDeltaWriter() override;
+    
+    void Write(uint64_t index, const MBPRecord& record, LevelMask changed) override;
+    void Flush() override;
+    void Close() override;
+};
+
+/**
+ * Replays a delta stream into full rows: applies each line's levels to
+ * the state left by the lines before it
+ */
+class MBPDeltaReader {
+private:
+    LineReader input_;
+    std::array<CompactPriceLevel, 2 * MBP_LEVELS> levels_{};
+    bool has_snapshot_{false};
+    uint64_t line_number_{1};
+
+public:
+    /**
+     * @throws std::runtime_error if the file cannot be read or is not a delta stream
+     */
+    explicit MBPDeltaReader(const std::string& filename);
+    
+    /**
+     * Read the next row
+     * @param index Set to the row index
+     * @param record Receives the fields the delta format carries (ts_event,
+     *        action, side, price, size, flags, sequence, order_id) and all
+     *        visible levels; other fields are left as they are
+     * @return False at end of file
+     * @throws std::runtime_error on a malformed line or an update before the first snapshot
+     */
+    bool Next(uint64_t& index, MBPRecord& record);
+};
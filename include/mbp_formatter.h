@@ -0,0 +1,51 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include <array>
+#include <string>
+
+/**
+ * Incremental CSV renderer for MBP rows
+ * 
+ * Design Principles:
+ * - Keep the rendered text of every level slot from the previous row
+ * - Re-format only slots flagged by the book's changed-level mask whose
+ *   price, size or count actually differ
+ * - Stitch the row together from cached slot text with memcpy
+ */
+class MBPRowFormatter {
+public:
+    /**
+     * Append one CSV row (index + MBPRecord::ToCSV() layout + newline)
+     * @param index Row index written in the first column
+     * @param record The MBP record to render
+     * @param changed Levels that may differ from the previous row
+     * @param out Buffer the row is appended to
+     */
+    void AppendRow(uint64_t index, const MBPRecord& record, LevelMask changed, std::string& out);
+    
+    /**
+     * Drop cached slot text so the next row is rendered in full
+     */
+    void Invalidate() { primed_ = false; }
+
+private:
+    // "price,size,count," for the widest price and 32-bit size/count
+    static constexpr size_t MAX_SLOT_CHARS = 48;
+    
+    struct SlotText {
+        CompactPriceLevel level;
+        std::array<char, MAX_SLOT_CHARS> text{};
+        uint8_t length{0};
+    };
+    
+    // Slots in CSV order: bid 0, ask 0, bid 1, ask 1, ...
+    std::array<SlotText, 2 * MBP_LEVELS> slots_;
+    bool primed_{false};
+    
+    /**
+     * Re-render a slot if its level values differ from the cached ones
+     */
+    void UpdateSlot(SlotText& slot, Price price, Size size, uint32_t count, bool force);
+};
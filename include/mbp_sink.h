@@ -0,0 +1,70 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include <string>
+#include <memory>
+
+/**
+ * Output encodings supported by MBOProcessor
+ */
+enum class OutputFormat {
+    CSV,     // 76-column text, written by MBOProcessor itself
+    Binary,  // Fixed-size little-endian MBP-10 records (DBN layout)
+    Columnar,// Row groups of per-column encoded data with a stats footer
+    Delta    // Changed levels only, with periodic full snapshots
+};
+
+/**
+ * Output encoding and its tuning knobs
+ */
+struct OutputOptions {
+    OutputFormat format{OutputFormat::CSV};
+    uint32_t snapshot_interval{1000};   // Delta: rows between full snapshots
+    size_t row_group_size{64 * 1024};   // Columnar: rows per row group
+    
+    // CSV file I/O
+    size_t buffer_size{1024 * 1024};    // Bytes accumulated before a buffer is written
+    uint32_t async_buffers{4};          // Buffers in the async writer rotation (0 = synchronous)
+    uint64_t preallocate_bytes{0};      // fallocate() reservation for the output file
+    uint32_t format_threads{0};         // CSV formatting worker threads (0 = format inline)
+};
+
+/**
+ * Parse an output format name ("csv", "binary", "columnar", "delta")
+ * @throws std::invalid_argument for unknown names
+ */
+OutputFormat ParseOutputFormat(const std::string& name);
+
+/**
+ * Destination for MBP records in a non-CSV encoding
+ */
+class MBPSink {
+public:
+    virtual ~MBPSink() = default;
+    
+    /**
+     * Write one MBP record
+     * @param index Row index of the record
+     * @param record The MBP record to write
+     * @param changed Levels that may differ from the previous record
+     */
+    virtual void Write(uint64_t index, const MBPRecord& record, LevelMask changed) = 0;
+    
+    /**
+     * Push buffered records to the underlying file
+     */
+    virtual void Flush() = 0;
+    
+    /**
+     * Flush and finalize the file (headers, footers)
+     */
+    virtual void Close() = 0;
+};
+
+/**
+ * Create the sink for a non-CSV output format
+ * @param filename Output file path
+ * @param options Output options (format must not be OutputFormat::CSV)
+ */
+std::unique_ptr<MBPSink> MakeMBPSink(const std::string& filename, const OutputOptions& options);
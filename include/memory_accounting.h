@@ -0,0 +1,259 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * Per-structure heap accounting and resident-set sampling
+ *
+ * Design Principles:
+ * - Containers that matter for sizing (price levels, per-level orders, the
+ *   order lookup, I/O buffers) allocate through CountingAllocator, which
+ *   keeps a current/peak byte count per category
+ * - Book categories change on every node allocation, so each thread counts
+ *   them in its own ThreadCounters without locked instructions; buffers
+ *   change rarely and from several threads, so they share atomic counters
+ * - The tracked peak is the peak of the total, not a sum of category peaks
+ *   (exact while a single thread owns the books)
+ * - Counts are requested bytes; malloc headers and fragmentation show up
+ *   only in the RSS figure
+ * - RSS comes from /proc/self/statm on a background thread, so nothing is
+ *   sampled on the record path
+ */
+namespace memory_accounting {
+
+enum class Category : uint8_t {
+    Levels,   // OrderBook price level map nodes
+    Orders,   // Per-level order maps (PriceLevel::orders)
+    Lookup,   // OrderBook order_id -> location map
+    Buffers,  // Input, output and writer buffers
+    COUNT
+};
+
+constexpr size_t kCategoryCount = static_cast<size_t>(Category::COUNT);
+
+// Categories before Buffers are charged to per-thread counters
+constexpr size_t kBookCategoryCount = static_cast<size_t>(Category::Buffers);
+
+constexpr bool IsBookCategory(Category category) {
+    return static_cast<size_t>(category) < kBookCategoryCount;
+}
+
+const char* CategoryName(Category category);
+
+/**
+ * Current and peak bytes of the buffer category, shared between threads
+ */
+struct alignas(64) ByteCounter {
+    std::atomic<int64_t> current{0};
+    std::atomic<int64_t> peak{0};
+    
+    void Add(size_t bytes) {
+        int64_t now = current.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+        int64_t seen = peak.load(std::memory_order_relaxed);
+        while (now > seen && !peak.compare_exchange_weak(seen, now, std::memory_order_relaxed)) {
+        }
+    }
+    
+    void Sub(size_t bytes) {
+        current.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+};
+
+inline ByteCounter g_buffer_counter;
+
+class RssSampler;
+
+/**
+ * Book category bytes allocated and freed on one thread
+ *
+ * Only the owning thread writes these, so an update is a relaxed load and
+ * store rather than a locked read-modify-write; they are atomics only so
+ * that Report() can read them from another thread. A thread's counters are
+ * registered on first use and folded into a retired total when it exits.
+ */
+class ThreadCounters {
+private:
+    std::atomic<int64_t> current_[kBookCategoryCount]{};
+    std::atomic<int64_t> peak_[kBookCategoryCount]{};
+    std::atomic<int64_t> total_{0};        // Sum of current_
+    std::atomic<int64_t> total_peak_{0};   // Peak of total_ plus buffer bytes
+    
+    static void Bump(std::atomic<int64_t>& value, int64_t delta) {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+    
+    static void Raise(std::atomic<int64_t>& peak, int64_t value) {
+        if (value > peak.load(std::memory_order_relaxed)) {
+            peak.store(value, std::memory_order_relaxed);
+        }
+    }
+    
+    friend void Report(std::ostream& out, const RssSampler* rss);
+    friend void AddBufferBytes(size_t bytes);
+
+public:
+    ThreadCounters();
+    ~ThreadCounters();
+    
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+    
+    void Add(Category category, size_t bytes) {
+        size_t index = static_cast<size_t>(category);
+        int64_t delta = static_cast<int64_t>(bytes);
+        Bump(current_[index], delta);
+        Raise(peak_[index], current_[index].load(std::memory_order_relaxed));
+        Bump(total_, delta);
+        Raise(total_peak_, total_.load(std::memory_order_relaxed) +
+                           g_buffer_counter.current.load(std::memory_order_relaxed));
+    }
+    
+    void Sub(Category category, size_t bytes) {
+        int64_t delta = static_cast<int64_t>(bytes);
+        Bump(current_[static_cast<size_t>(category)], -delta);
+        Bump(total_, -delta);
+    }
+};
+
+inline ThreadCounters& LocalCounters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+/**
+ * Charge buffer bytes; also raises the tracked peak by the total across threads
+ */
+void AddBufferBytes(size_t bytes);
+
+inline void Charge(Category category, size_t bytes) {
+    if (IsBookCategory(category)) {
+        LocalCounters().Add(category, bytes);
+    } else {
+        AddBufferBytes(bytes);
+    }
+}
+
+inline void Release(Category category, size_t bytes) {
+    if (IsBookCategory(category)) {
+        LocalCounters().Sub(category, bytes);
+    } else {
+        g_buffer_counter.Sub(bytes);
+    }
+}
+
+/**
+ * std::allocator that charges its allocations to a category
+ */
+template <typename T, Category C>
+struct CountingAllocator {
+    using value_type = T;
+    
+    template <typename U>
+    struct rebind {
+        using other = CountingAllocator<U, C>;
+    };
+    
+    CountingAllocator() noexcept = default;
+    
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U, C>&) noexcept {}
+    
+    T* allocate(size_t n) {
+        T* memory = std::allocator<T>().allocate(n);
+        Charge(C, n * sizeof(T));
+        return memory;
+    }
+    
+    void deallocate(T* memory, size_t n) noexcept {
+        std::allocator<T>().deallocate(memory, n);
+        Release(C, n * sizeof(T));
+    }
+    
+    template <typename U>
+    bool operator==(const CountingAllocator<U, C>&) const noexcept { return true; }
+    
+    template <typename U>
+    bool operator!=(const CountingAllocator<U, C>&) const noexcept { return false; }
+};
+
+/**
+ * Bytes owned by storage that cannot take an allocator (e.g. std::string
+ * buffers swapped with callers); Set() re-charges the category by the difference
+ */
+class TrackedBytes {
+private:
+    Category category_;
+    size_t bytes_{0};
+
+public:
+    explicit TrackedBytes(Category category) : category_(category) {}
+    ~TrackedBytes() { Set(0); }
+    
+    TrackedBytes(const TrackedBytes&) = delete;
+    TrackedBytes& operator=(const TrackedBytes&) = delete;
+    
+    void Set(size_t bytes) {
+        if (bytes > bytes_) {
+            Charge(category_, bytes - bytes_);
+        } else if (bytes < bytes_) {
+            Release(category_, bytes_ - bytes);
+        }
+        bytes_ = bytes;
+    }
+};
+
+/**
+ * Resident set size from /proc/self/statm, or 0 where unavailable
+ */
+uint64_t ReadRssBytes();
+
+/**
+ * Samples RSS on a background thread until destroyed
+ */
+class RssSampler {
+private:
+    uint64_t interval_ns_;
+    std::atomic<uint64_t> current_bytes_{0};
+    std::atomic<uint64_t> peak_bytes_{0};
+    std::atomic<uint64_t> samples_{0};
+    std::mutex mutex_;
+    std::condition_variable stop_cv_;
+    bool stopping_{false};
+    std::thread thread_;
+    
+    void Sample();
+    void Run();
+
+public:
+    /**
+     * @param interval_ns Time between samples (default: 100ms)
+     */
+    explicit RssSampler(uint64_t interval_ns = 100 * 1000000ULL);
+    ~RssSampler();
+    
+    RssSampler(const RssSampler&) = delete;
+    RssSampler& operator=(const RssSampler&) = delete;
+    
+    /**
+     * Take one more sample now (e.g. at the end of a run) and stop the thread
+     */
+    void Stop();
+    
+    uint64_t CurrentBytes() const { return current_bytes_.load(std::memory_order_relaxed); }
+    uint64_t PeakBytes() const { return peak_bytes_.load(std::memory_order_relaxed); }
+    uint64_t SampleCount() const { return samples_.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Print current and peak bytes per category, their total and (if given) RSS
+ */
+void Report(std::ostream& out, const RssSampler* rss);
+
+} // namespace memory_accounting
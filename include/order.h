@@ -2,6 +2,7 @@
 
 #include "types.h"
 #include "utils.h"
+#include "memory_accounting.h"
 #include <vector>
 #include <unordered_map>
 
@@ -35,7 +36,9 @@ struct PriceLevel {
     uint32_t order_count{0};
     
     // Map of order_id to order size for efficient lookups
-    std::unordered_map<OrderID, Size> orders;
+    using OrderSizes = std::unordered_map<OrderID, Size, std::hash<OrderID>, std::equal_to<OrderID>,
+        memory_accounting::CountingAllocator<std::pair<const OrderID, Size>, memory_accounting::Category::Orders>>;
+    OrderSizes orders;
     
     PriceLevel() = default;
     
@@ -18,8 +18,10 @@
 class OrderBook {
 private:
     // Price levels: price -> PriceLevel (automatically sorted)
-    using LevelOrders = std::map<Price, PriceLevel, std::greater<Price>>;  // Bids: descending
-    using AskLevels = std::map<Price, PriceLevel, std::less<Price>>;       // Asks: ascending
+    using LevelAllocator = memory_accounting::CountingAllocator<std::pair<const Price, PriceLevel>,
+                                                                memory_accounting::Category::Levels>;
+    using LevelOrders = std::map<Price, PriceLevel, std::greater<Price>, LevelAllocator>;  // Bids: descending
+    using AskLevels = std::map<Price, PriceLevel, std::less<Price>, LevelAllocator>;       // Asks: ascending
     
     LevelOrders bids_;
     AskLevels asks_;
@@ -32,11 +34,16 @@ private:
         OrderLocation() : price(0), side(0) {}
         OrderLocation(Price p, char s) : price(p), side(s) {}
     };
-    std::unordered_map<OrderID, OrderLocation> order_lookup_;
+    std::unordered_map<OrderID, OrderLocation, std::hash<OrderID>, std::equal_to<OrderID>,
+        memory_accounting::CountingAllocator<std::pair<const OrderID, OrderLocation>,
+                                             memory_accounting::Category::Lookup>> order_lookup_;
     
     // Track if order book changed (for MBP output optimization)
     bool has_changes_{false};
     
+    // Visible levels touched or shifted since the last ConsumeChangedLevels()
+    LevelMask changed_levels_{0};
+    
     // Pre-allocated vectors for MBP output
     mutable std::vector<CompactPriceLevel> bid_levels_cache_;
     mutable std::vector<CompactPriceLevel> ask_levels_cache_;
@@ -74,6 +81,31 @@ public:
      */
     void ResetChanges() { has_changes_ = false; }
     
+    /**
+     * Check if an update since the last consumed snapshot touched a level
+     * within the top MBP_LEVELS or shifted one into or out of it
+     */
+    bool HasVisibleChanges() const { return changed_levels_ != 0; }
+    
+    /**
+     * Get the mask of top-N levels that may differ from the last consumed snapshot
+     */
+    LevelMask ChangedLevels() const { return changed_levels_; }
+    
+    /**
+     * Return the changed-level mask and start accumulating a new one
+     */
+    LevelMask ConsumeChangedLevels() {
+        LevelMask changed = changed_levels_;
+        changed_levels_ = 0;
+        return changed;
+    }
+    
+    /**
+     * Flag levels as changed again, e.g. when a consumed mask went unused
+     */
+    void MarkChangedLevels(LevelMask levels) { changed_levels_ |= levels; }
+    
     /**
      * Clear the entire order book
      */
@@ -95,6 +127,13 @@ public:
         Price best_ask;
     };
     Statistics GetStatistics() const;
+    
+    /**
+     * Validate order book consistency: lookup and levels agree, and level
+     * totals match their orders (for debugging and differential tests)
+     * @return False after printing the first inconsistency to stderr
+     */
+    bool ValidateConsistency() const;
 
 private:
     /**
@@ -133,7 +172,8 @@ private:
     void MarkChanged() { has_changes_ = true; }
     
     /**
-     * Validate order book consistency (for debugging)
+     * Flag the visible level at the given price as changed
+     * @param shifted True if a level was inserted or removed, moving all deeper levels
      */
-    bool ValidateConsistency() const;
+    void MarkLevelChanged(char side, Price price, bool shifted);
 }; 
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "types.h"
+#include "order.h"
+#include "records.h"
+#include "mbp_formatter.h"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Text field of a snapshot: inline up to N bytes, spilled to the heap
+ * beyond that so an unusually long value never costs its row
+ */
+template <size_t N>
+struct SnapshotText {
+    uint8_t length{0};
+    bool spilled{false};
+    char data[N];
+    std::string spill;
+    
+    void Assign(const std::string& value) {
+        spilled = value.size() > N;
+        if (spilled) {
+            spill = value;
+        } else {
+            std::memcpy(data, value.data(), value.size());
+            length = static_cast<uint8_t>(value.size());
+        }
+    }
+    
+    void CopyTo(std::string& out) const {
+        if (spilled) {
+            out = spill;
+        } else {
+            out.assign(data, length);
+        }
+    }
+};
+
+/**
+ * Copy of an MBP row handed from the book thread to formatters
+ * (fixed size unless a text field spills)
+ */
+struct MBPSnapshot {
+    uint64_t index;
+    Price price;
+    OrderID order_id;
+    uint32_t publisher_id;
+    uint32_t instrument_id;
+    uint32_t depth;
+    Size size;
+    int32_t ts_in_delta;
+    Sequence sequence;
+    uint8_t rtype;
+    uint8_t flags;
+    char action;
+    char side;
+    SnapshotText<32> ts_recv;
+    SnapshotText<32> ts_event;
+    SnapshotText<32> symbol;      // DBN symbols are up to 21 characters (22 with NUL)
+    CompactPriceLevel bids[MBP_LEVELS];
+    CompactPriceLevel asks[MBP_LEVELS];
+    
+    /**
+     * Capture an MBP record
+     */
+    void Assign(uint64_t row_index, const MBPRecord& record);
+    
+    /**
+     * Restore into an existing record, reusing its string capacity
+     */
+    void CopyTo(MBPRecord& record) const;
+};
+
+/**
+ * Multi-threaded CSV formatter with ordered reassembly
+ * 
+ * Design Principles:
+ * - The book thread only copies a fixed-size snapshot into a batch
+ * - Worker threads render whole batches into text chunks, reusing level
+ *   text between consecutive rows of a batch (MBPRowFormatter)
+ * - A sequencer thread hands chunks to the writer strictly in order
+ * - Batches come from a bounded pool, so a slow writer applies
+ *   back-pressure instead of growing memory
+ */
+class ParallelRowFormatter {
+public:
+    using ChunkWriter = std::function<void(std::string& chunk)>;
+    
+    /**
+     * @param thread_count Formatting worker threads (min 1)
+     * @param batch_size Rows per batch / text chunk
+     * @param writer Called on the sequencer thread with each chunk, in row order
+     */
+    ParallelRowFormatter(size_t thread_count, size_t batch_size, ChunkWriter writer);
+    ~ParallelRowFormatter();
+    
+    ParallelRowFormatter(const ParallelRowFormatter&) = delete;
+    ParallelRowFormatter& operator=(const ParallelRowFormatter&) = delete;
+    
+    /**
+     * Queue one row for formatting
+     */
+    void Push(uint64_t index, const MBPRecord& record);
+    
+    /**
+     * Queue the partially filled batch without waiting for it
+     */
+    void Flush();
+    
+    /**
+     * Format and write everything queued, then stop the threads
+     */
+    void Finish();
+
+private:
+    struct Batch {
+        uint64_t sequence{0};
+        std::vector<MBPSnapshot> rows;
+        std::string text;
+    };
+    
+    size_t batch_size_;
+    ChunkWriter writer_;
+    
+    std::mutex mutex_;
+    std::condition_variable work_cv_;       // Workers: batch queued or stopping
+    std::condition_variable done_cv_;       // Sequencer: batch formatted or stopping
+    std::condition_variable free_cv_;       // Book thread: batch returned to the pool
+    std::vector<Batch*> free_;
+    std::deque<Batch*> queued_;
+    std::map<uint64_t, Batch*> formatted_;
+    std::vector<std::unique_ptr<Batch>> batches_;
+    uint64_t next_sequence_{0};
+    uint64_t next_to_write_{0};
+    bool stopping_{false};
+    bool finished_{false};
+    std::exception_ptr error_;
+    
+    Batch* current_{nullptr};
+    std::vector<std::thread> workers_;
+    std::thread sequencer_;
+    
+    Batch* AcquireBatch();
+    void SubmitCurrent();
+    void RunWorker();
+    void RunSequencer();
+    void RethrowError();
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "types.h"
+#include "order.h"
+#include "records.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace persistent_book {
+
+/**
+ * Maximum levels per chunk; a chunk that grows past this is split in two
+ */
+constexpr size_t kChunkLevels = 32;
+
+/**
+ * Run of consecutive price levels, best price first
+ */
+struct LevelChunk {
+    std::vector<CompactPriceLevel> levels;
+};
+
+/**
+ * One side of the book as a list of chunks
+ *
+ * Both the list and its chunks are reference counted: a snapshot holds the
+ * list, the writer copies whichever of the two is still shared before it
+ * mutates it (path copying), so untouched chunks stay shared between
+ * every snapshot and the live book.
+ */
+struct SideLevels {
+    std::vector<std::shared_ptr<LevelChunk>> chunks;
+    size_t level_count{0};
+};
+
+} // namespace persistent_book
+
+/**
+ * Immutable full-depth view of a PersistentOrderBook at one point in the stream
+ *
+ * Taking one is O(1) (two reference count increments) and it stays valid and
+ * unchanged while the writer keeps applying records, so it can be handed to
+ * another thread and traversed at leisure.
+ */
+class OrderBookSnapshot {
+private:
+    std::shared_ptr<const persistent_book::SideLevels> bids_;
+    std::shared_ptr<const persistent_book::SideLevels> asks_;
+    uint64_t version_{0};
+    size_t order_count_{0};
+    
+    friend class PersistentOrderBook;
+    
+    const persistent_book::SideLevels* Side(char side) const;
+
+public:
+    OrderBookSnapshot() = default;
+    
+    /**
+     * Number of records applied to the book when the snapshot was taken
+     */
+    uint64_t Version() const { return version_; }
+    
+    size_t OrderCount() const { return order_count_; }
+    
+    /**
+     * Number of price levels on a side (BID_SIDE or ASK_SIDE)
+     */
+    size_t LevelCount(char side) const;
+    
+    /**
+     * Visit every level of a side, best price first
+     * @param fn Called as fn(const CompactPriceLevel&)
+     */
+    template <typename Fn>
+    void ForEachLevel(char side, Fn&& fn) const {
+        const persistent_book::SideLevels* levels = Side(side);
+        if (levels == nullptr) {
+            return;
+        }
+        for (const auto& chunk : levels->chunks) {
+            for (const CompactPriceLevel& level : chunk->levels) {
+                fn(level);
+            }
+        }
+    }
+    
+    /**
+     * Best `levels` levels of a side, best price first
+     */
+    std::vector<CompactPriceLevel> GetTopLevels(char side, size_t levels) const;
+};
+
+/**
+ * Order book whose level structure is persistent
+ *
+ * Design Principles:
+ * - Same Apply() semantics as OrderBook, so the two can be swapped
+ * - Levels kept as chunked sorted arrays with copy-on-write chunks
+ * - Snapshot() is O(1); the first write to a shared chunk afterwards copies
+ *   that chunk and the chunk list, later writes to it are in place again
+ * - Order lookup is writer-private and never shared
+ */
+class PersistentOrderBook {
+private:
+    using SidePtr = std::shared_ptr<persistent_book::SideLevels>;
+    
+    SidePtr bids_;
+    SidePtr asks_;
+    
+    // Order lookup: order_id -> (price, side, size)
+    struct OrderEntry {
+        Price price;
+        Size size;
+        char side;
+    };
+    std::unordered_map<OrderID, OrderEntry> order_lookup_;
+    
+    uint64_t version_{0};
+    uint64_t chunks_copied_{0};
+    
+    void AddOrder(const MBORecord& record);
+    void CancelOrder(const MBORecord& record);
+    void ModifyOrder(const MBORecord& record);
+    
+    /**
+     * Add size and count deltas to the level at a price, creating or removing it as needed
+     */
+    void AdjustLevel(char side, Price price, int64_t size_delta, int32_t count_delta);
+    
+    /**
+     * The side's chunk list, copied first if a snapshot still shares it
+     */
+    persistent_book::SideLevels& MutableSide(char side);
+    
+    /**
+     * A chunk of a writable side, copied first if a snapshot still shares it
+     */
+    persistent_book::LevelChunk& MutableChunk(persistent_book::SideLevels& levels, size_t index);
+
+public:
+    PersistentOrderBook();
+    
+    /**
+     * Apply an MBO record to the order book
+     */
+    void Apply(const MBORecord& record);
+    
+    /**
+     * Clear the entire order book; existing snapshots are unaffected
+     */
+    void Clear();
+    
+    /**
+     * Immutable view of the current book
+     */
+    OrderBookSnapshot Snapshot() const;
+    
+    size_t OrderCount() const { return order_lookup_.size(); }
+    
+    /**
+     * Chunks copied because a snapshot was sharing them (writer overhead)
+     */
+    uint64_t ChunksCopied() const { return chunks_copied_; }
+};
@@ -34,7 +34,7 @@ struct MBORecord {
     /**
      * Parse MBO record from CSV line
      */
-    static MBORecord Parse(const std::string& line);
+    static MBORecord Parse(std::string_view line);
     
     /**
      * Check if this is a top-of-book message
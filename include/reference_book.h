@@ -0,0 +1,68 @@
+#pragma once
+
+#include "types.h"
+#include "records.h"
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * Deliberately simple order book used as the oracle when testing OrderBook
+ *
+ * Design Principles:
+ * - Stores individual orders only; levels are aggregated on every query, so
+ *   there are no level totals, caches or change masks that could drift
+ * - Same observable semantics as OrderBook, including which records throw
+ *   and which exception type they throw
+ * - Sizes are summed in 64 bits, so a narrower aggregate in the book under
+ *   test shows up as a divergence rather than wrapping the same way twice
+ * - Correctness over speed: O(orders in the returned levels) per query
+ */
+class ReferenceBook {
+public:
+    struct Level {
+        Price price{kUndefPrice};
+        uint64_t size{0};
+        uint32_t count{0};
+    };
+
+private:
+    struct RestingOrder {
+        char side;
+        Price price;
+        Size size;
+    };
+    
+    std::map<OrderID, RestingOrder> orders_;
+    
+    // (price, order ID) -> size per side; bids are read from the back
+    std::map<std::pair<Price, OrderID>, Size> bids_;
+    std::map<std::pair<Price, OrderID>, Size> asks_;
+    
+    void Insert(OrderID order_id, const RestingOrder& order);
+    void Erase(std::map<OrderID, RestingOrder>::iterator it);
+
+public:
+    /**
+     * Apply an MBO record
+     * @throws std::invalid_argument for invalid records, and for adds or
+     *         modifies whose side is neither bid nor ask
+     * @throws std::runtime_error for an add whose order ID already rests
+     */
+    void Apply(const MBORecord& record);
+    
+    void Clear();
+    
+    /**
+     * Best `levels` price levels of a side, best first
+     */
+    std::vector<Level> TopLevels(char side, size_t levels) const;
+    
+    /**
+     * Distinct prices resting on a side (walks every order)
+     */
+    size_t LevelCount(char side) const;
+    
+    size_t OrderCount() const { return orders_.size(); }
+};
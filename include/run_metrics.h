@@ -0,0 +1,94 @@
+#pragma once
+
+#include "stage_timer.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Machine-readable run metrics for dashboards
+ *
+ * Design Principles:
+ * - The processor fills a RunMetrics snapshot; MetricsExporter only
+ *   serialises it, as JSON or as a Prometheus textfile (".prom" files)
+ * - Files are written next to their destination and renamed into place,
+ *   so a scraper never reads a half-written file
+ * - Rewritten at most once per interval while records flow, and once more
+ *   with complete = true when the run ends
+ */
+struct RunMetrics {
+    uint64_t records_processed{0};
+    uint64_t records_rejected{0};      // Input lines or records that failed to parse or apply
+    uint64_t rows_written{0};
+    uint64_t rows_suppressed{0};
+    uint64_t bytes_in{0};              // As read from the input (compressed for .gz)
+    uint64_t bytes_out{0};             // CSV text produced (before compression), or the file size
+    double elapsed_seconds{0.0};
+    uint64_t bid_levels{0};
+    uint64_t ask_levels{0};
+    uint64_t resting_orders{0};
+    uint64_t rss_bytes{0};
+    
+    // Per-record latency (zero when performance monitoring is off)
+    double latency_p50_ns{0.0};
+    double latency_p99_ns{0.0};
+    double latency_max_ns{0.0};
+    
+    // Stage totals (STAGE_TIMERS=1 builds): the book thread while running,
+    // every thread in the final snapshot
+    std::vector<stage_timer::ThreadTotals> stages;
+    
+    uint64_t metrics_write_errors{0};  // Periodic writes that failed so far
+    bool complete{false};
+};
+
+/**
+ * Serialise metrics as a JSON document
+ */
+void WriteMetricsJson(std::ostream& out, const RunMetrics& metrics);
+
+/**
+ * Serialise metrics in the Prometheus text exposition format
+ */
+void WriteMetricsPrometheus(std::ostream& out, const RunMetrics& metrics);
+
+/**
+ * Rewrites metrics files periodically during a run
+ */
+class MetricsExporter {
+private:
+    std::vector<std::string> paths_;
+    uint64_t interval_ns_;
+    uint64_t next_write_ns_;
+    uint64_t writes_{0};
+    uint64_t failures_{0};
+
+public:
+    /**
+     * @param paths Destination files; ".prom" files get the Prometheus format, others JSON
+     * @param interval_ns Minimum time between periodic rewrites
+     */
+    MetricsExporter(std::vector<std::string> paths, uint64_t interval_ns);
+    
+    /**
+     * Whether the interval has elapsed since the last write
+     */
+    bool Due() const;
+    
+    /**
+     * Write every destination (temporary file + rename) and restart the interval
+     * @throws std::runtime_error if a file cannot be written
+     */
+    void Write(const RunMetrics& metrics);
+    
+    /**
+     * Write() for periodic updates: a failure is counted and logged once,
+     * never thrown, and the interval restarts either way
+     * @return False if a file could not be written
+     */
+    bool TryWrite(const RunMetrics& metrics);
+    
+    uint64_t Writes() const { return writes_; }
+    uint64_t Failures() const { return failures_; }
+};
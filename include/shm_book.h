@@ -0,0 +1,153 @@
+#pragma once
+
+#include "types.h"
+#include "order.h"
+#include "records.h"
+#include "utils.h"
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Shared-memory top-of-book region
+ * 
+ * A header followed by one cache-line aligned slot per instrument. Each
+ * slot is guarded by a seqlock: the single writer makes the sequence odd,
+ * copies the book in, and makes it even again; readers copy the slot and
+ * retry if the sequence was odd or changed underneath them. Readers never
+ * block the writer.
+ */
+namespace shm_book {
+
+constexpr char MAGIC[4] = {'M', 'B', 'S', 'H'};
+constexpr uint32_t VERSION = 1;
+
+/**
+ * Book state of one instrument as published
+ */
+struct BookSnapshot {
+    uint32_t instrument_id;
+    uint32_t publisher_id;
+    uint64_t update_count;        // Snapshots published for this instrument
+    uint64_t ts_event;            // Nanoseconds since UNIX epoch of the last update
+    uint64_t ts_recv;
+    Price price;                  // Last update's MBO fields
+    Size size;
+    Sequence sequence;
+    char action;
+    char side;
+    uint8_t flags;
+    uint8_t depth;
+    CompactPriceLevel bids[MBP_LEVELS];
+    CompactPriceLevel asks[MBP_LEVELS];
+};
+
+struct alignas(64) Slot {
+    std::atomic<uint64_t> sequence;   // Odd while the writer is inside; twice the update count
+    uint32_t instrument_id;           // Set once before the slot is made visible
+    BookSnapshot book;
+};
+
+struct alignas(64) Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t capacity;                     // Slots in the region
+    uint32_t slot_size;
+    std::atomic<uint32_t> instrument_count;  // Slots in use; grows only
+};
+
+// Attempts a reader makes before deciding the writer died inside an update
+constexpr uint32_t READ_RETRY_LIMIT = 1u << 22;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Seqlock needs a lock-free 64-bit atomic");
+
+/**
+ * Full shared-memory name ("/name") for a user-supplied name
+ */
+std::string SegmentName(const std::string& name);
+
+} // namespace shm_book
+
+/**
+ * Single-writer publisher of per-instrument books into shared memory
+ */
+class ShmBookPublisher {
+private:
+    std::string name_;
+    void* region_{nullptr};
+    size_t region_size_{0};
+    shm_book::Header* header_{nullptr};
+    shm_book::Slot* slots_{nullptr};
+    std::unordered_map<uint32_t, shm_book::Slot*> slot_by_instrument_;
+    shm_book::Slot* last_slot_{nullptr};   // Most feeds carry a single instrument
+    uint32_t last_instrument_{0};
+    utils::TimestampParser ts_event_parser_;
+    utils::TimestampParser ts_recv_parser_;
+    
+    shm_book::Slot* SlotFor(uint32_t instrument_id);
+
+public:
+    /**
+     * Create (or recreate) the region; it outlives the publisher so readers
+     * can still see the final book
+     * @param name Segment name, e.g. "mbp_book" (appears as /dev/shm/mbp_book)
+     * @param capacity Maximum number of instruments
+     * @throws std::runtime_error if the region cannot be created
+     */
+    ShmBookPublisher(const std::string& name, uint32_t capacity = 1024);
+    ~ShmBookPublisher();
+    
+    ShmBookPublisher(const ShmBookPublisher&) = delete;
+    ShmBookPublisher& operator=(const ShmBookPublisher&) = delete;
+    
+    /**
+     * Publish the record's book for its instrument
+     * @throws std::runtime_error if a new instrument exceeds the capacity
+     */
+    void Publish(const MBPRecord& record);
+};
+
+/**
+ * Reader of a region written by ShmBookPublisher
+ */
+class ShmBookReader {
+private:
+    const void* region_{nullptr};
+    size_t region_size_{0};
+    const shm_book::Header* header_{nullptr};
+    const shm_book::Slot* slots_{nullptr};
+    mutable std::unordered_map<uint32_t, const shm_book::Slot*> slot_by_instrument_;
+    
+    const shm_book::Slot* FindSlot(uint32_t instrument_id) const;
+
+public:
+    /**
+     * Attach read-only to an existing region
+     * @throws std::runtime_error if it does not exist or has a different layout
+     */
+    explicit ShmBookReader(const std::string& name);
+    ~ShmBookReader();
+    
+    ShmBookReader(const ShmBookReader&) = delete;
+    ShmBookReader& operator=(const ShmBookReader&) = delete;
+    
+    /**
+     * Instruments published so far
+     */
+    std::vector<uint32_t> Instruments() const;
+    
+    /**
+     * Take a consistent copy of an instrument's book
+     * @return False if the instrument has not been published
+     * @throws std::runtime_error if the slot stays mid-update for
+     *         READ_RETRY_LIMIT attempts (the writer died during an update)
+     */
+    bool Read(uint32_t instrument_id, shm_book::BookSnapshot& out) const;
+    
+    /**
+     * Update count of an instrument without copying the book (0 if unknown);
+     * a single atomic load, so pollers can skip unchanged books cheaply
+     */
+    uint64_t UpdateCount(uint32_t instrument_id) const;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "hw_counters.h"
+#include "utils.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Per-stage cycle accounting for the conversion pipeline
+ *
+ * Built with `make STAGE_TIMERS=1` (-DMBO_STAGE_TIMERS), STAGE_TIMER and
+ * STAGE_TIMED read CycleClock around each stage and add the ticks to a
+ * thread-local table; ticks are only converted to time when reported.
+ * In the default build both macros expand to nothing / the bare
+ * expression, so the instrumented code compiles exactly as before.
+ * 
+ * A thread that attaches an HwCounters group also gets hardware counter
+ * deltas per stage (one group read at each stage boundary, so only for
+ * benchmark runs).
+ */
+namespace stage_timer {
+
+enum class Stage : uint8_t {
+    Parse,     // MBORecord::Parse
+    Apply,     // OrderBook::Apply / Clear
+    Snapshot,  // GetTopBids / GetTopAsks into an MBPRecord
+    Format,    // CSV row rendering or non-CSV encoding
+    Write,     // Handing buffers to the OS (or the writer thread)
+    COUNT
+};
+
+constexpr size_t kStageCount = static_cast<size_t>(Stage::COUNT);
+
+#ifdef MBO_STAGE_TIMERS
+constexpr bool kEnabled = true;
+#else
+constexpr bool kEnabled = false;
+#endif
+
+const char* StageName(Stage stage);
+
+/**
+ * One thread's accumulated ticks and calls per stage
+ */
+struct ThreadTotals {
+    std::string name;
+    uint64_t ticks[kStageCount] = {};
+    uint64_t calls[kStageCount] = {};
+    HwCounts hw[kStageCount];
+    const HwCounters* hw_counters{nullptr};   // Attached group, read around each stage
+    bool hw_open[kHwEventCount] = {};         // Events the attached group counted
+};
+
+/**
+ * The calling thread's table, registered on first use
+ */
+ThreadTotals& LocalTotals();
+
+/**
+ * Label the calling thread's row in the report (e.g. "book", "writer")
+ */
+void SetThreadName(const char* name);
+
+/**
+ * Read the given counter group around every stage on the calling thread
+ * @param counters Group opened on this thread, or nullptr to detach
+ */
+void AttachHwCounters(const HwCounters* counters);
+
+/**
+ * Adds the ticks spent in its scope to the calling thread's table
+ */
+class ScopedTimer {
+private:
+    ThreadTotals& totals_;
+    Stage stage_;
+    HwCounts hw_start_;
+    uint64_t start_;
+
+public:
+    explicit ScopedTimer(Stage stage) : totals_(LocalTotals()), stage_(stage) {
+        if (totals_.hw_counters != nullptr) {
+            hw_start_ = totals_.hw_counters->Read();
+        }
+        start_ = utils::CycleClock::Now();
+    }
+    
+    ~ScopedTimer() {
+        size_t index = static_cast<size_t>(stage_);
+        totals_.ticks[index] += utils::CycleClock::Now() - start_;
+        totals_.calls[index]++;
+        if (totals_.hw_counters != nullptr) {
+            totals_.hw[index] += totals_.hw_counters->Read() - hw_start_;
+        }
+    }
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+/**
+ * Evaluate fn() as one call of the given stage
+ */
+template <typename Fn>
+inline auto Timed(Stage stage, Fn&& fn) -> decltype(fn()) {
+    ScopedTimer timer(stage);
+    return fn();
+}
+
+/**
+ * Print a per-thread, per-stage breakdown table
+ *
+ * Reads every thread's table without synchronisation; call it once the
+ * instrumented threads have finished (MBOProcessor does so from its final stats).
+ */
+void Report(std::ostream& out);
+
+/**
+ * Write the same breakdown as JSON
+ * @throws std::runtime_error if the file cannot be written
+ */
+void WriteJson(const std::string& filename);
+
+/**
+ * Copy of every table that timed something (same synchronisation caveat as Report)
+ */
+std::vector<ThreadTotals> CollectTotals();
+
+} // namespace stage_timer
+
+#define STAGE_TIMER_CONCAT_INNER(a, b) a##b
+#define STAGE_TIMER_CONCAT(a, b) STAGE_TIMER_CONCAT_INNER(a, b)
+
+#ifdef MBO_STAGE_TIMERS
+/**
+ * Time the rest of the enclosing scope as the given stage (e.g. STAGE_TIMER(Write);)
+ */
+#define STAGE_TIMER(stage) \
+    ::stage_timer::ScopedTimer STAGE_TIMER_CONCAT(stage_timer_scope_, __LINE__)(::stage_timer::Stage::stage)
+
+/**
+ * Time one expression as the given stage and yield its value
+ */
+#define STAGE_TIMED(stage, expr) ::stage_timer::Timed(::stage_timer::Stage::stage, [&]() -> decltype(auto) { return expr; })
+
+#define STAGE_THREAD_NAME(name) ::stage_timer::SetThreadName(name)
+#else
+#define STAGE_TIMER(stage) static_cast<void>(0)
+#define STAGE_TIMED(stage, expr) (expr)
+#define STAGE_THREAD_NAME(name) static_cast<void>(0)
+#endif
@@ -18,6 +18,12 @@ using Sequence = uint32_t;
 constexpr int MBP_LEVELS = 10;
 constexpr Price kUndefPrice = INT64_MAX;  // 9223372036854775807
 
+// Changed-level mask: bit i is bid level i, bit MBP_LEVELS + i is ask level i
+using LevelMask = uint32_t;
+static_assert(2 * MBP_LEVELS <= 32, "LevelMask must hold a bit per visible level");
+constexpr LevelMask kSideLevelsMask = (LevelMask{1} << MBP_LEVELS) - 1;
+constexpr LevelMask kAllLevelsChanged = (kSideLevelsMask << MBP_LEVELS) | kSideLevelsMask;
+
 // Side constants
 constexpr char BID_SIDE = 'B';
 constexpr char ASK_SIDE = 'A';
@@ -0,0 +1,187 @@
+#include "async_writer.h"
+#include "stage_timer.h"
+#include "utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+AsyncFileWriter::AsyncFileWriter(const std::string& filename, size_t buffer_count, size_t buffer_size,
+                                 uint64_t preallocate_bytes) {
+    if (filename == "-") {
+        fd_ = STDOUT_FILENO;
+        seekable_ = false;
+    } else {
+        fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open output file: " + filename + ": " + std::strerror(errno));
+        }
+        
+        // Devices and pipes (e.g. /dev/null) get sequential writes and no truncation
+        struct stat info;
+        seekable_ = ::fstat(fd_, &info) == 0 && S_ISREG(info.st_mode);
+    }
+    
+    if (utils::IsGzipPath(filename)) {
+        encoder_ = std::make_unique<GzipEncoder>();
+    }
+    
+    // Reserve blocks without changing the file size; unsupported filesystems just skip it
+    if (seekable_ && preallocate_bytes > 0) {
+        ::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(preallocate_bytes));
+    }
+    
+    // One buffer is always held by the producer
+    buffer_count = std::max<size_t>(buffer_count, 2);
+    free_.resize(buffer_count - 1);
+    for (auto& buffer : free_) {
+        buffer.reserve(buffer_size);
+    }
+    pool_bytes_.Set(free_.size() * buffer_size);
+    
+    thread_ = std::thread(&AsyncFileWriter::Run, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    try {
+        Close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error closing output file: " << e.what() << std::endl;
+    }
+}
+
+void AsyncFileWriter::Submit(std::string& buffer) {
+    if (buffer.empty()) {
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    free_cv_.wait(lock, [this] { return !free_.empty() || error_; });
+    RethrowError();
+    
+    pending_.emplace_back();
+    pending_.back().swap(buffer);
+    buffer.swap(free_.back());
+    free_.pop_back();
+    lock.unlock();
+    
+    ready_cv_.notify_one();
+}
+
+void AsyncFileWriter::Close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_cv_.notify_one();
+    thread_.join();
+    
+    // gzip trailer, written after the thread has drained every buffer
+    if (encoder_ && !error_) {
+        try {
+            compressed_.clear();
+            encoder_->Finish(compressed_);
+            WriteBytes(compressed_.data(), compressed_.size());
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+    }
+    
+    // Release preallocated blocks past the data actually written
+    int truncate_errno = 0;
+    if (seekable_ && ::ftruncate(fd_, static_cast<off_t>(file_offset_)) != 0) {
+        truncate_errno = errno;
+    }
+    
+    // Some filesystems (e.g. NFS) only report deferred write errors from close(2)
+    int close_errno = 0;
+    if (fd_ != STDOUT_FILENO && ::close(fd_) != 0) {
+        close_errno = errno;
+    }
+    fd_ = -1;
+    
+    RethrowError();
+    if (truncate_errno != 0) {
+        throw std::runtime_error(std::string("Failed to truncate output file: ") + std::strerror(truncate_errno));
+    }
+    if (close_errno != 0) {
+        throw std::runtime_error(std::string("Failed to close output file: ") + std::strerror(close_errno));
+    }
+}
+
+void AsyncFileWriter::Run() {
+    STAGE_THREAD_NAME("writer");
+    std::unique_lock<std::mutex> lock(mutex_);
+    
+    while (true) {
+        ready_cv_.wait(lock, [this] { return !pending_.empty() || stopping_; });
+        if (pending_.empty()) {
+            return;  // Stopping and fully drained
+        }
+        
+        std::string buffer;
+        buffer.swap(pending_.front());
+        pending_.pop_front();
+        lock.unlock();
+        
+        try {
+            if (!error_) {
+                WriteAll(buffer);
+            }
+        } catch (...) {
+            lock.lock();
+            error_ = std::current_exception();
+            lock.unlock();
+        }
+        buffer.clear();
+        
+        lock.lock();
+        free_.push_back(std::move(buffer));
+        free_cv_.notify_one();
+    }
+}
+
+void AsyncFileWriter::WriteAll(const std::string& buffer) {
+    STAGE_TIMER(Write);
+    if (encoder_) {
+        compressed_.clear();
+        encoder_->Compress(buffer.data(), buffer.size(), compressed_);
+        WriteBytes(compressed_.data(), compressed_.size());
+    } else {
+        WriteBytes(buffer.data(), buffer.size());
+    }
+}
+
+void AsyncFileWriter::WriteBytes(const char* data, size_t remaining) {
+    if (!seekable_) {
+        utils::WriteFully(fd_, data, remaining);
+        file_offset_ += remaining;
+        return;
+    }
+    
+    while (remaining > 0) {
+        ssize_t written = ::pwrite(fd_, data, remaining, static_cast<off_t>(file_offset_));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Failed to write output file: ") + std::strerror(errno));
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+        file_offset_ += static_cast<uint64_t>(written);
+    }
+}
+
+void AsyncFileWriter::RethrowError() {
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
@@ -0,0 +1,211 @@
+#include "batch_converter.h"
+#include "gzip_stream.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <glob.h>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+bool HasGlobCharacters(const std::string& pattern) {
+    return pattern.find_first_of("*?[") != std::string::npos;
+}
+
+const char* FormatExtension(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Binary:
+            return ".mbp";
+        case OutputFormat::Columnar:
+            return ".mbpc";
+        case OutputFormat::Delta:
+            return ".delta";
+        case OutputFormat::CSV:
+        default:
+            return ".csv";
+    }
+}
+
+} // namespace
+
+BatchConverter::BatchConverter(const OutputOptions& output_options, Configure configure)
+    : output_options_(output_options), configure_(std::move(configure)) {}
+
+std::vector<std::string> BatchConverter::ExpandInputs(const std::vector<std::string>& patterns) {
+    std::vector<std::string> inputs;
+    for (const auto& pattern : patterns) {
+        if (!HasGlobCharacters(pattern)) {
+            inputs.push_back(pattern);
+            continue;
+        }
+        
+        glob_t matches{};
+        int status = ::glob(pattern.c_str(), 0, nullptr, &matches);
+        if (status != 0) {
+            globfree(&matches);
+            throw std::runtime_error("No input files match " + pattern);
+        }
+        for (size_t i = 0; i < matches.gl_pathc; ++i) {
+            inputs.emplace_back(matches.gl_pathv[i]);
+        }
+        globfree(&matches);
+    }
+    
+    // A file named twice (or matched by two patterns) is converted once
+    std::sort(inputs.begin(), inputs.end());
+    inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+    return inputs;
+}
+
+std::string BatchConverter::OutputPath(const std::string& input_file, const std::string& output_dir,
+                                       OutputFormat format) {
+    std::filesystem::path input(input_file);
+    bool gzip_input = utils::IsGzipPath(input_file);
+    if (gzip_input) {
+        input = input.stem();
+    }
+    
+    std::string name = input.stem().string() + "_mbp" + FormatExtension(format);
+    
+    // Compressed CSV in, compressed CSV out
+    if (gzip_input && format == OutputFormat::CSV) {
+        name += ".gz";
+    }
+    return (std::filesystem::path(output_dir) / name).string();
+}
+
+std::vector<BatchJob> BatchConverter::PlanJobs(const std::vector<std::string>& input_files,
+                                               const std::string& output_dir) const {
+    std::vector<BatchJob> jobs;
+    jobs.reserve(input_files.size());
+    for (const auto& input_file : input_files) {
+        BatchJob job;
+        job.input_file = input_file;
+        job.output_file = OutputPath(input_file, output_dir, output_options_.format);
+        std::error_code error;
+        auto size = std::filesystem::file_size(input_file, error);
+        job.input_bytes = error ? 0 : size;
+        jobs.push_back(std::move(job));
+    }
+    
+    // Two inputs with the same stem in different directories would overwrite each other
+    std::vector<std::string> outputs;
+    for (const auto& job : jobs) {
+        outputs.push_back(job.output_file);
+    }
+    std::sort(outputs.begin(), outputs.end());
+    auto duplicate = std::adjacent_find(outputs.begin(), outputs.end());
+    if (duplicate != outputs.end()) {
+        throw std::invalid_argument("Two inputs map to the same output file: " + *duplicate);
+    }
+    
+    std::stable_sort(jobs.begin(), jobs.end(), [](const BatchJob& a, const BatchJob& b) {
+        return a.input_bytes > b.input_bytes;
+    });
+    return jobs;
+}
+
+BatchResult BatchConverter::Convert(const BatchJob& job) const {
+    // MBOProcessor's constructor touches process-wide iostream settings
+    static std::mutex construct_mutex;
+    
+    BatchResult result;
+    result.job = job;
+    uint64_t start_ns = utils::MonotonicNanos();
+    
+    try {
+        OutputOptions options = output_options_;
+        if (options.preallocate_bytes == 0 && !utils::IsGzipPath(job.output_file)) {
+            // MBP rows are roughly three times the size of the MBO lines they come from
+            options.preallocate_bytes = job.input_bytes * 3;
+        }
+        
+        std::unique_ptr<MBOProcessor> processor;
+        {
+            std::lock_guard<std::mutex> lock(construct_mutex);
+            processor = std::make_unique<MBOProcessor>(job.output_file, options);
+        }
+        
+        // Per-file reports would interleave; the batch prints one summary
+        processor->SetPerformanceMonitoring(false);
+        configure_(*processor);
+        processor->ProcessFile(job.input_file);
+        processor->Close();   // Write errors fail the job before the file counts as done
+        
+        auto stats = processor->GetStats();
+        result.records_processed = stats.records_processed;
+        result.mbp_records_generated = stats.mbp_records_generated;
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    
+    result.elapsed_ns = utils::MonotonicNanos() - start_ns;
+    return result;
+}
+
+std::vector<BatchResult> BatchConverter::Run(const std::vector<BatchJob>& jobs, unsigned threads) const {
+    std::vector<BatchResult> results(jobs.size());
+    std::atomic<size_t> next_job{0};
+    
+    auto worker = [&] {
+        for (size_t index = next_job.fetch_add(1); index < jobs.size(); index = next_job.fetch_add(1)) {
+            results[index] = Convert(jobs[index]);
+        }
+    };
+    
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(jobs.size())));
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();   // The calling thread is one of the workers
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return results;
+}
+
+void BatchConverter::Report(std::ostream& out, const std::vector<BatchResult>& results, uint64_t wall_ns) {
+    uint64_t total_records = 0;
+    uint64_t total_rows = 0;
+    uint64_t total_bytes = 0;
+    uint64_t busy_ns = 0;
+    size_t failed = 0;
+    
+    out << "\n=== Batch Summary ===\n";
+    out << std::left << std::setw(40) << "Input" << std::right << std::setw(10) << "MB" << std::setw(12) << "Records"
+        << std::setw(12) << "MBP rows" << std::setw(10) << "ms" << std::setw(14) << "records/sec" << "\n";
+    for (const auto& result : results) {
+        out << std::left << std::setw(40) << result.job.input_file << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << result.job.input_bytes / 1e6;
+        if (!result.error.empty()) {
+            out << "  FAILED: " << result.error << "\n";
+            ++failed;
+            continue;
+        }
+        out << std::setw(12) << result.records_processed << std::setw(12) << result.mbp_records_generated
+            << std::setw(10) << result.elapsed_ns / 1000000 << std::setprecision(0) << std::setw(14)
+            << result.RecordsPerSecond() << "\n";
+        total_records += result.records_processed;
+        total_rows += result.mbp_records_generated;
+        total_bytes += result.job.input_bytes;
+        busy_ns += result.elapsed_ns;
+    }
+    
+    out << std::setprecision(0);
+    out << "Files: " << results.size() - failed << " converted, " << failed << " failed\n";
+    out << "Records processed: " << total_records << "  MBP records generated: " << total_rows << "\n";
+    out << "Wall time: " << wall_ns / 1000000 << "ms  Input: " << std::setprecision(1) << total_bytes / 1e6 << "MB\n";
+    out << std::setprecision(0);
+    if (wall_ns > 0) {
+        out << "Overall rate: " << total_records * 1e9 / wall_ns << " records/sec";
+        out << " (" << std::setprecision(2) << static_cast<double>(busy_ns) / wall_ns << " files in flight on average)\n";
+    }
+    out << "=====================\n";
+    out << std::defaultfloat << std::setprecision(6);
+}
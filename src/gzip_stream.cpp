@@ -0,0 +1,99 @@
+#include "gzip_stream.h"
+#include <stdexcept>
+
+namespace {
+
+// windowBits + 16 selects the gzip wrapper instead of raw zlib
+constexpr int GZIP_WINDOW_BITS = 15 + 16;
+
+} // namespace
+
+GzipEncoder::GzipEncoder(int level) {
+    if (deflateInit2(&stream_, level, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Failed to initialize gzip compressor");
+    }
+}
+
+GzipEncoder::~GzipEncoder() {
+    deflateEnd(&stream_);
+}
+
+void GzipEncoder::Compress(const char* data, size_t size, std::string& out) {
+    Run(data, size, Z_NO_FLUSH, out);
+}
+
+void GzipEncoder::Finish(std::string& out) {
+    if (!finished_) {
+        Run(nullptr, 0, Z_FINISH, out);
+        finished_ = true;
+    }
+}
+
+void GzipEncoder::Run(const char* data, size_t size, int flush, std::string& out) {
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream_.avail_in = static_cast<uInt>(size);
+    
+    while (true) {
+        // Grow the output by the worst-case bound of what is left
+        size_t offset = out.size();
+        size_t chunk = deflateBound(&stream_, stream_.avail_in) + 64;
+        out.resize(offset + chunk);
+        stream_.next_out = reinterpret_cast<Bytef*>(&out[offset]);
+        stream_.avail_out = static_cast<uInt>(chunk);
+        
+        int result = deflate(&stream_, flush);
+        out.resize(offset + chunk - stream_.avail_out);
+        
+        if (result == Z_STREAM_ERROR) {
+            throw std::runtime_error("gzip compression failed");
+        }
+        if (flush == Z_FINISH ? result == Z_STREAM_END : stream_.avail_in == 0) {
+            return;
+        }
+    }
+}
+
+GzipDecoder::GzipDecoder() {
+    if (inflateInit2(&stream_, GZIP_WINDOW_BITS) != Z_OK) {
+        throw std::runtime_error("Failed to initialize gzip decompressor");
+    }
+}
+
+GzipDecoder::~GzipDecoder() {
+    inflateEnd(&stream_);
+}
+
+size_t GzipDecoder::Inflate(const char* in, size_t in_size, size_t& consumed, char* out, size_t out_size) {
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+    stream_.avail_in = static_cast<uInt>(in_size);
+    stream_.next_out = reinterpret_cast<Bytef*>(out);
+    stream_.avail_out = static_cast<uInt>(out_size);
+    
+    while (stream_.avail_in > 0 && stream_.avail_out > 0) {
+        if (member_complete_) {
+            // Start of the next concatenated member
+            inflateReset(&stream_);
+            member_complete_ = false;
+        }
+        
+        int result = inflate(&stream_, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            member_complete_ = true;
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+            throw std::runtime_error(std::string("Corrupt gzip input: ") + (stream_.msg ? stream_.msg : "inflate failed"));
+        } else if (result == Z_BUF_ERROR) {
+            break;
+        }
+    }
+    
+    consumed = in_size - stream_.avail_in;
+    return out_size - stream_.avail_out;
+}
+
+namespace utils {
+
+bool IsGzipPath(const std::string& filename) {
+    return filename.size() > 3 && filename.compare(filename.size() - 3, 3, ".gz") == 0;
+}
+
+} // namespace utils
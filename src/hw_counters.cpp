@@ -0,0 +1,154 @@
+#include "hw_counters.h"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+EventConfig ConfigFor(HwEvent event) {
+    switch (event) {
+        case HwEvent::Cycles:
+            return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+        case HwEvent::Instructions:
+            return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+        case HwEvent::BranchMisses:
+            return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES};
+        case HwEvent::L1DMisses:
+            return {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+        case HwEvent::LLCMisses:
+            return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+        case HwEvent::TaskClockNs:
+            return {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK};
+        case HwEvent::PageFaults:
+        default:
+            return {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS};
+    }
+}
+
+int OpenEvent(HwEvent event, int group_fd) {
+    EventConfig config = ConfigFor(event);
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = config.type;
+    attr.config = config.config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = group_fd < 0 ? 1 : 0;   // The leader starts the whole group
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+double PerRecord(uint64_t value, uint64_t records) {
+    return records > 0 ? static_cast<double>(value) / static_cast<double>(records) : 0.0;
+}
+
+} // namespace
+
+const char* HwEventName(HwEvent event) {
+    switch (event) {
+        case HwEvent::Cycles: return "cycles";
+        case HwEvent::Instructions: return "instructions";
+        case HwEvent::BranchMisses: return "branch_misses";
+        case HwEvent::L1DMisses: return "l1d_misses";
+        case HwEvent::LLCMisses: return "llc_misses";
+        case HwEvent::TaskClockNs: return "task_clock_ns";
+        case HwEvent::PageFaults: return "page_faults";
+        default: return "unknown";
+    }
+}
+
+HwCounters::HwCounters() {
+    std::string unavailable;
+    for (size_t i = 0; i < kHwEventCount; ++i) {
+        fds_[i] = -1;
+        slot_[i] = 0;
+        HwEvent event = static_cast<HwEvent>(i);
+        int fd = OpenEvent(event, leader_fd_);
+        if (fd < 0) {
+            unavailable += std::string(unavailable.empty() ? "" : ", ") + HwEventName(event) + " (" + std::strerror(errno) + ")";
+            continue;
+        }
+        if (leader_fd_ < 0) {
+            leader_fd_ = fd;
+        }
+        fds_[i] = fd;
+        slot_[i] = open_count_++;
+    }
+    
+    if (leader_fd_ >= 0) {
+        ::ioctl(leader_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(leader_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    
+    if (open_count_ == 0) {
+        status_ = "no performance counters available: " + unavailable;
+    } else if (!unavailable.empty()) {
+        status_ = "not counted: " + unavailable;
+    } else {
+        status_ = "all events counted";
+    }
+}
+
+HwCounters::~HwCounters() {
+    for (size_t i = 0; i < kHwEventCount; ++i) {
+        if (fds_[i] >= 0) {
+            ::close(fds_[i]);
+        }
+    }
+}
+
+HwCounts HwCounters::Read() const {
+    HwCounts counts;
+    if (leader_fd_ < 0) {
+        return counts;
+    }
+    
+    // PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, value[nr]
+    uint64_t buffer[3 + kHwEventCount] = {};
+    ssize_t bytes = ::read(leader_fd_, buffer, sizeof(buffer));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[0] != open_count_) {
+        return counts;
+    }
+    
+    uint64_t enabled = buffer[1];
+    uint64_t running = buffer[2];
+    double scale = (running > 0 && running < enabled) ? static_cast<double>(enabled) / running : 1.0;
+    for (size_t i = 0; i < kHwEventCount; ++i) {
+        if (fds_[i] >= 0) {
+            uint64_t raw = buffer[3 + slot_[i]];
+            counts.values[i] = scale == 1.0 ? raw : static_cast<uint64_t>(raw * scale);
+        }
+    }
+    return counts;
+}
+
+void HwCounters::Report(std::ostream& out, const std::string& title, const HwCounts& counts, uint64_t records) const {
+    out << title << " (" << status_ << ")\n";
+    if (!Available()) {
+        return;
+    }
+    
+    out << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < kHwEventCount; ++i) {
+        if (fds_[i] < 0) {
+            continue;
+        }
+        out << "  " << std::left << std::setw(16) << HwEventName(static_cast<HwEvent>(i)) << std::right
+            << std::setw(16) << counts.values[i] << std::setw(14) << PerRecord(counts.values[i], records) << " per record\n";
+    }
+    if (IsOpen(HwEvent::Cycles) && IsOpen(HwEvent::Instructions) && counts[HwEvent::Cycles] > 0) {
+        out << std::setprecision(2) << "  IPC " << static_cast<double>(counts[HwEvent::Instructions]) / counts[HwEvent::Cycles] << "\n";
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
@@ -0,0 +1,120 @@
+#include "line_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+LineReader::LineReader(const std::string& filename, size_t buffer_size)
+    : buffer_(std::max<size_t>(buffer_size, 4096)) {
+    if (filename == "-") {
+        fd_ = STDIN_FILENO;
+    } else {
+        fd_ = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open input file: " + filename);
+        }
+        owns_fd_ = true;
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        
+        if (utils::IsGzipPath(filename)) {
+            decoder_ = std::make_unique<GzipDecoder>();
+            compressed_.resize(buffer_.size());
+        }
+    }
+}
+
+LineReader::~LineReader() {
+    if (owns_fd_) {
+        ::close(fd_);
+    }
+}
+
+bool LineReader::ReadLine(std::string_view& line) {
+    size_t scan_from = begin_;
+    
+    while (true) {
+        const char* data = buffer_.data();
+        const void* newline = std::memchr(data + scan_from, '\n', end_ - scan_from);
+        if (newline != nullptr) {
+            size_t line_end = static_cast<const char*>(newline) - data;
+            line = std::string_view(data + begin_, line_end - begin_);
+            begin_ = line_end + 1;
+            return true;
+        }
+        
+        if (eof_) {
+            // Final line without a terminating newline
+            if (begin_ < end_) {
+                line = std::string_view(data + begin_, end_ - begin_);
+                begin_ = end_;
+                return true;
+            }
+            return false;
+        }
+        
+        // Keep the partial line at the front and read more after it
+        size_t partial = end_ - begin_;
+        if (begin_ > 0) {
+            std::memmove(buffer_.data(), buffer_.data() + begin_, partial);
+            begin_ = 0;
+            end_ = partial;
+        }
+        if (end_ == buffer_.size()) {
+            buffer_.resize(buffer_.size() * 2);
+        }
+        scan_from = end_;
+        Fill();
+    }
+}
+
+void LineReader::Fill() {
+    if (!decoder_) {
+        size_t count = ReadRaw(buffer_.data() + end_, buffer_.size() - end_);
+        eof_ = (count == 0);
+        end_ += count;
+        return;
+    }
+    
+    // Inflate until at least one byte is produced or the input ends
+    while (true) {
+        if (compressed_begin_ == compressed_end_) {
+            compressed_begin_ = 0;
+            compressed_end_ = ReadRaw(compressed_.data(), compressed_.size());
+            if (compressed_end_ == 0) {
+                if (!decoder_->AtMemberBoundary()) {
+                    throw std::runtime_error("Truncated gzip input");
+                }
+                eof_ = true;
+                return;
+            }
+        }
+        
+        size_t consumed = 0;
+        size_t produced = decoder_->Inflate(compressed_.data() + compressed_begin_,
+                                            compressed_end_ - compressed_begin_, consumed,
+                                            buffer_.data() + end_, buffer_.size() - end_);
+        compressed_begin_ += consumed;
+        end_ += produced;
+        if (produced > 0) {
+            return;
+        }
+    }
+}
+
+size_t LineReader::ReadRaw(char* dest, size_t capacity) {
+    if (before_read_) {
+        before_read_();
+    }
+    
+    while (true) {
+        ssize_t count = ::read(fd_, dest, capacity);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Failed to read input: ") + std::strerror(errno));
+        }
+        bytes_read_ += static_cast<uint64_t>(count);
+        return static_cast<size_t>(count);
+    }
+}
@@ -1,23 +1,268 @@
+#include "batch_converter.h"
 #include "mbo_processor.h"
+#include "stage_timer.h"
 #include "utils.h"
 #include <iostream>
 #include <stdexcept>
 #include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Parsed command line
+ */
+struct CommandLineOptions {
+    std::string input_file;
+    std::string output_file{"mbp_output.csv"};
+    OutputOptions output;
+    bool preallocate_set{false};
+    uint64_t flush_interval_ns{0};
+    bool flush_interval_set{false};
+    bool conflate_events{false};
+    bool visible_changes_only{false};
+    uint64_t sample_interval_ns{0};
+    bool fill_empty_buckets{false};
+    StreamOptions stream;
+    bool stream_input{false};     // Live socket / FIFO ingestion instead of a file
+    std::string shm_name;         // Shared-memory book segment, empty = off
+    std::string stage_json;       // Per-stage breakdown JSON, empty = off
+    bool hw_counters{false};      // perf_event counters on the book thread
+    std::vector<std::string> metrics_out;        // JSON / Prometheus textfile destinations
+    uint64_t metrics_interval_ns{10 * 1000000000ULL};
+    bool batch{false};            // Convert every positional input into output_dir
+    std::vector<std::string> batch_inputs;
+    std::string output_dir{"."};
+    unsigned jobs{0};             // Batch worker threads, 0 = one per core
+};
 
 void PrintUsage(const char* program_name) {
-    std::cout << "Usage: " << program_name << " <input_mbo_file> [output_mbp_file]\n";
+    std::cout << "Usage: " << program_name << " [options] <input_mbo_file> [output_mbp_file]\n";
+    std::cout << "       " << program_name << " --batch [options] [--output-dir DIR] <input|glob>...\n";
     std::cout << "\n";
     std::cout << "Description:\n";
     std::cout << "  Converts Market By Order (MBO) data to Market By Price (MBP) format\n";
     std::cout << "  with top 10 price levels for both bid and ask sides.\n";
     std::cout << "\n";
     std::cout << "Arguments:\n";
-    std::cout << "  input_mbo_file   Input MBO CSV file path\n";
-    std::cout << "  output_mbp_file  Output MBP CSV file path (optional, defaults to mbp_output.csv)\n";
+    std::cout << "  input_mbo_file   Input MBO CSV file path, - for stdin, a FIFO, or unix:/path to listen on a socket\n";
+    std::cout << "  output_mbp_file  Output MBP file path, or - for stdout (optional, defaults to mbp_output.csv)\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --format <csv|binary|columnar|delta>\n";
+    std::cout << "                         Output encoding (default: csv)\n";
+    std::cout << "                         binary writes fixed-size MBP-10 records in the DBN layout\n";
+    std::cout << "                         columnar writes delta/RLE encoded row groups with a stats footer\n";
+    std::cout << "                         delta writes only changed levels plus periodic snapshots\n";
+    std::cout << "  --delta                Same as --format delta\n";
+    std::cout << "  --snapshot-interval N  Delta rows between full snapshots (default: 1000, 0 = first row only)\n";
+    std::cout << "  --row-group-size N     Columnar rows per row group (default: 65536)\n";
+    std::cout << "  --conflate             Emit one row per event, when the F_LAST record arrives\n";
+    std::cout << "  --visible-changes-only Skip rows when only levels below the top 10 changed\n";
+    std::cout << "  --sample-interval D    Emit a snapshot per ts_event bucket of width D (e.g. 100us, 1ms, 1s)\n";
+    std::cout << "  --fill-empty-buckets   With --sample-interval, repeat the snapshot for buckets without records\n";
+    std::cout << "  --format-threads N     Format CSV rows on N worker threads (default: 0 = inline)\n";
+    std::cout << "  --flush-interval D     Flush buffered rows at least every D (e.g. 10ms; default: 100ms for stdout)\n";
+    std::cout << "  --buffer-size BYTES    CSV output buffer size (default: 1048576)\n";
+    std::cout << "  --async-buffers N      CSV buffers written by a background thread (default: 4, 0 = synchronous)\n";
+    std::cout << "  --preallocate BYTES    Reserve output file space up front (default: 3x input size)\n";
+    std::cout << "  --input-format <csv|binary>\n";
+    std::cout << "                         Framing of a live input stream (default: csv); binary is\n";
+    std::cout << "                         a stream header plus 56-byte DBN MBO messages\n";
+    std::cout << "  --busy-poll            Spin on the live input instead of blocking in read(2)\n";
+    std::cout << "  --shm-publish NAME     Also publish each book to shared memory /dev/shm/NAME (see shm_reader)\n";
+    std::cout << "  --stage-json FILE      Write the per-stage cycle breakdown as JSON (build with STAGE_TIMERS=1)\n";
+    std::cout << "  --hw-counters          Report cycles, instructions, IPC and cache/branch misses per record\n";
+    std::cout << "  --metrics-out FILE     Export run metrics as JSON, or as a Prometheus textfile for .prom\n";
+    std::cout << "                         files; repeatable, rewritten periodically and at the end\n";
+    std::cout << "  --metrics-interval D   Minimum time between metrics rewrites (default: 10s)\n";
+    std::cout << "  --batch                Convert many files concurrently; positional arguments are inputs\n";
+    std::cout << "                         or quoted glob patterns, largest files are scheduled first\n";
+    std::cout << "  --output-dir DIR       Batch output directory (default: .); NAME.csv becomes DIR/NAME_mbp.csv\n";
+    std::cout << "  --jobs N               Batch worker threads (default: one per core)\n";
     std::cout << "\n";
     std::cout << "Example:\n";
     std::cout << "  " << program_name << " mbo.csv mbp_output.csv\n";
     std::cout << "  " << program_name << " data/mbo.csv\n";
+    std::cout << "  " << program_name << " --format binary mbo.csv mbp_output.mbp\n";
+    std::cout << "  zcat mbo.csv.gz | " << program_name << " - - | downstream\n";
+    std::cout << "  " << program_name << " --input-format binary --busy-poll unix:/tmp/mbo.sock live_mbp.csv\n";
+    std::cout << "  " << program_name << " --batch --output-dir out/ --jobs 8 'archive/*.csv.gz'\n";
+}
+
+/**
+ * Parse command line arguments
+ * @return False if the arguments are invalid and usage should be printed
+ */
+bool ParseArguments(int argc, char* argv[], CommandLineOptions& options) {
+    std::vector<std::string> positional;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--format") {
+            if (i + 1 >= argc) return false;
+            options.output.format = ParseOutputFormat(argv[++i]);
+        } else if (arg == "--delta") {
+            options.output.format = OutputFormat::Delta;
+        } else if (arg == "--snapshot-interval") {
+            if (i + 1 >= argc) return false;
+            options.output.snapshot_interval = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--row-group-size") {
+            if (i + 1 >= argc) return false;
+            options.output.row_group_size = std::stoull(argv[++i]);
+        } else if (arg == "--conflate") {
+            options.conflate_events = true;
+        } else if (arg == "--visible-changes-only") {
+            options.visible_changes_only = true;
+        } else if (arg == "--sample-interval") {
+            if (i + 1 >= argc) return false;
+            options.sample_interval_ns = utils::ParseDuration(argv[++i]);
+        } else if (arg == "--fill-empty-buckets") {
+            options.fill_empty_buckets = true;
+        } else if (arg == "--format-threads") {
+            if (i + 1 >= argc) return false;
+            options.output.format_threads = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--flush-interval") {
+            if (i + 1 >= argc) return false;
+            options.flush_interval_ns = utils::ParseDuration(argv[++i]);
+            options.flush_interval_set = true;
+        } else if (arg == "--buffer-size") {
+            if (i + 1 >= argc) return false;
+            options.output.buffer_size = std::stoull(argv[++i]);
+        } else if (arg == "--async-buffers") {
+            if (i + 1 >= argc) return false;
+            options.output.async_buffers = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--preallocate") {
+            if (i + 1 >= argc) return false;
+            options.output.preallocate_bytes = std::stoull(argv[++i]);
+            options.preallocate_set = true;
+        } else if (arg == "--input-format") {
+            if (i + 1 >= argc) return false;
+            std::string framing = argv[++i];
+            if (framing == "csv") {
+                options.stream.framing = StreamFraming::CSV;
+            } else if (framing == "binary") {
+                options.stream.framing = StreamFraming::Binary;
+                options.stream_input = true;
+            } else {
+                throw std::invalid_argument("Unknown input format: " + framing);
+            }
+        } else if (arg == "--shm-publish") {
+            if (i + 1 >= argc) return false;
+            options.shm_name = argv[++i];
+        } else if (arg == "--stage-json") {
+            if (i + 1 >= argc) return false;
+            options.stage_json = argv[++i];
+        } else if (arg == "--hw-counters") {
+            options.hw_counters = true;
+        } else if (arg == "--metrics-out") {
+            if (i + 1 >= argc) return false;
+            options.metrics_out.push_back(argv[++i]);
+        } else if (arg == "--metrics-interval") {
+            if (i + 1 >= argc) return false;
+            options.metrics_interval_ns = utils::ParseDuration(argv[++i]);
+        } else if (arg == "--batch") {
+            options.batch = true;
+        } else if (arg == "--output-dir") {
+            if (i + 1 >= argc) return false;
+            options.output_dir = argv[++i];
+        } else if (arg == "--jobs") {
+            if (i + 1 >= argc) return false;
+            options.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--busy-poll") {
+            options.stream.busy_poll = true;
+            options.stream_input = true;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    
+    if (options.batch) {
+        if (positional.empty()) {
+            return false;
+        }
+        if (options.stream_input || !options.shm_name.empty() || !options.metrics_out.empty() ||
+            !options.stage_json.empty() || options.hw_counters) {
+            throw std::invalid_argument("--batch converts files; live inputs, --shm-publish, --metrics-out, "
+                                        "--stage-json and --hw-counters are not supported");
+        }
+        options.batch_inputs = std::move(positional);
+        return true;   // Per-file output preallocation is sized by BatchConverter
+    }
+    
+    if (positional.empty() || positional.size() > 2) {
+        return false;
+    }
+    
+    options.input_file = positional[0];
+    if (positional.size() == 2) {
+        options.output_file = positional[1];
+    }
+    
+    if (MBOStreamReader::IsStreamSource(options.input_file)) {
+        options.stream_input = true;
+    }
+    
+    // Pipelines should see rows promptly even when input trickles in
+    if (options.output_file == "-" && !options.flush_interval_set) {
+        options.flush_interval_ns = 100 * 1000000ULL;
+    }
+    
+    // MBP rows are roughly three times the size of the MBO lines they come from
+    if (!options.preallocate_set) {
+        std::error_code error;
+        auto input_size = std::filesystem::file_size(options.input_file, error);
+        if (!error) {
+            options.output.preallocate_bytes = input_size * 3;
+        }
+    }
+    return true;
+}
+
+/**
+ * Apply the command-line processing options to a processor
+ */
+void ConfigureProcessor(MBOProcessor& processor, const CommandLineOptions& options) {
+    processor.SetSkipFirstRecord(true);  // Skip initial clear record as per requirements
+    processor.SetValidateOutput(true);   // Validate output format
+    processor.SetConflateEvents(options.conflate_events);
+    processor.SetVisibleChangesOnly(options.visible_changes_only);
+    processor.SetSampleInterval(options.sample_interval_ns, options.fill_empty_buckets);
+    processor.SetFlushInterval(options.flush_interval_ns);
+}
+
+/**
+ * Convert every batch input into the output directory on a thread pool
+ */
+int RunBatch(const CommandLineOptions& options) {
+    std::vector<std::string> inputs = BatchConverter::ExpandInputs(options.batch_inputs);
+    std::filesystem::create_directories(options.output_dir);
+    
+    BatchConverter converter(options.output, [&options](MBOProcessor& processor) {
+        ConfigureProcessor(processor, options);
+    });
+    std::vector<BatchJob> jobs = converter.PlanJobs(inputs, options.output_dir);
+    unsigned threads = options.jobs > 0 ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+    
+    std::cout << "=== MBO to MBP Batch Converter ===\n";
+    std::cout << "Input files: " << jobs.size() << "\n";
+    std::cout << "Output dir:  " << options.output_dir << "\n";
+    std::cout << "Threads:     " << std::min<size_t>(threads, jobs.size()) << "\n";
+    
+    uint64_t start_ns = utils::MonotonicNanos();
+    std::vector<BatchResult> results = converter.Run(jobs, threads);
+    BatchConverter::Report(std::cout, results, utils::MonotonicNanos() - start_ns);
+    
+    for (const auto& result : results) {
+        if (!result.error.empty()) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
@@ -26,32 +271,57 @@ int main(int argc, char* argv[]) {
         utils::EnableFastIO();
         
         // Parse command line arguments
-        if (argc < 2 || argc > 3) {
+        CommandLineOptions options;
+        if (!ParseArguments(argc, argv, options)) {
             PrintUsage(argv[0]);
             return 1;
         }
         
-        std::string input_file = argv[1];
-        std::string output_file = (argc == 3) ? argv[2] : "mbp_output.csv";
+        if (options.batch) {
+            return RunBatch(options);
+        }
+        
+        const std::string& input_file = options.input_file;
+        const std::string& output_file = options.output_file;
         
-        std::cout << "=== MBO to MBP Converter ===\n";
-        std::cout << "Input file:  " << input_file << "\n";
-        std::cout << "Output file: " << output_file << "\n";
-        std::cout << "============================\n\n";
+        // Progress text must not mix with MBP rows written to stdout
+        std::ostream& info = (output_file == "-") ? std::cerr : std::cout;
+        
+        info << "=== MBO to MBP Converter ===\n";
+        info << "Input file:  " << input_file << "\n";
+        info << "Output file: " << output_file << "\n";
+        info << "============================\n\n";
         
         // Start timing
         auto start_time = std::chrono::high_resolution_clock::now();
         
         // Create processor and process file
-        MBOProcessor processor(output_file);
+        MBOProcessor processor(output_file, options.output);
         
         // Configure processor
-        processor.SetSkipFirstRecord(true);  // Skip initial clear record as per requirements
-        processor.SetValidateOutput(true);   // Validate output format
+        ConfigureProcessor(processor, options);
         processor.SetPerformanceMonitoring(true);  // Enable performance monitoring
+        if (!options.stage_json.empty()) {
+            if (!stage_timer::kEnabled) {
+                std::cerr << "Warning: stage timers are compiled out; rebuild with make STAGE_TIMERS=1\n";
+            }
+            processor.SetStageReportFile(options.stage_json);
+        }
+        processor.SetHwCounters(options.hw_counters);
+        if (!options.metrics_out.empty()) {
+            processor.SetMetricsOutput(options.metrics_out, options.metrics_interval_ns);
+        }
+        if (!options.shm_name.empty()) {
+            processor.SetShmPublisher(options.shm_name);
+        }
         
-        // Process the file
-        processor.ProcessFile(input_file);
+        // Process the file, or a live stream until its writer disconnects
+        if (options.stream_input) {
+            processor.ProcessStream(input_file, options.stream);
+        } else {
+            processor.ProcessFile(input_file);
+        }
+        processor.Close();
         
         // End timing
         auto end_time = std::chrono::high_resolution_clock::now();
@@ -60,13 +330,13 @@ int main(int argc, char* argv[]) {
         // Get final statistics
         auto stats = processor.GetStats();
         
-        std::cout << "\n=== Conversion Complete ===\n";
-        std::cout << "Total processing time: " << duration.count() << "ms\n";
-        std::cout << "Records processed: " << stats.records_processed << "\n";
-        std::cout << "MBP records generated: " << stats.mbp_records_generated << "\n";
-        std::cout << "Processing rate: " << stats.records_per_second << " records/sec\n";
-        std::cout << "Output saved to: " << output_file << "\n";
-        std::cout << "==========================\n";
+        info << "\n=== Conversion Complete ===\n";
+        info << "Total processing time: " << duration.count() << "ms\n";
+        info << "Records processed: " << stats.records_processed << "\n";
+        info << "MBP records generated: " << stats.mbp_records_generated << "\n";
+        info << "Processing rate: " << stats.records_per_second << " records/sec\n";
+        info << "Output saved to: " << output_file << "\n";
+        info << "==========================\n";
         
         return 0;
         
@@ -0,0 +1,68 @@
+#include "mbo_binary.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace mbo_binary {
+
+mbp_binary::FileHeader MakeHeader(const std::string& symbol) {
+    mbp_binary::FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.record_size = sizeof(MBOMsg);
+    std::memcpy(header.symbol, symbol.data(), std::min(symbol.size(), sizeof(header.symbol)));
+    return header;
+}
+
+std::string CheckHeader(const mbp_binary::FileHeader& header) {
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a binary MBO stream (bad magic)");
+    }
+    if (header.record_size != sizeof(MBOMsg)) {
+        throw std::runtime_error("Unsupported MBO record size: " + std::to_string(header.record_size));
+    }
+    return std::string(header.symbol, strnlen(header.symbol, sizeof(header.symbol)));
+}
+
+MBOMsg Encode(const MBORecord& record) {
+    MBOMsg out{};
+    
+    out.hd.length = sizeof(MBOMsg) / 4;
+    out.hd.rtype = record.rtype;
+    out.hd.publisher_id = record.publisher_id;
+    out.hd.instrument_id = record.instrument_id;
+    out.hd.ts_event = utils::ParseTimestamp(record.ts_event);
+    out.order_id = record.order_id;
+    out.price = record.price;
+    out.size = record.size;
+    out.flags = record.flags;
+    out.channel_id = record.channel_id;
+    out.action = record.action;
+    out.side = record.side;
+    out.ts_recv = utils::ParseTimestamp(record.ts_recv);
+    out.ts_in_delta = record.ts_in_delta;
+    out.sequence = record.sequence;
+    
+    return out;
+}
+
+void Decode(const MBOMsg& message, const std::string& symbol, MBORecord& record) {
+    record.ts_recv = utils::FormatTimestamp(message.ts_recv);
+    record.ts_event = utils::FormatTimestamp(message.hd.ts_event);
+    record.rtype = message.hd.rtype;
+    record.publisher_id = message.hd.publisher_id;
+    record.instrument_id = message.hd.instrument_id;
+    record.action = message.action;
+    record.side = message.side;
+    record.price = message.price;
+    record.size = message.size;
+    record.channel_id = message.channel_id;
+    record.order_id = message.order_id;
+    record.flags = message.flags;
+    record.ts_in_delta = message.ts_in_delta;
+    record.sequence = message.sequence;
+    record.symbol = symbol;
+}
+
+} // namespace mbo_binary
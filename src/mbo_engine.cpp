@@ -0,0 +1,182 @@
+#include "mbo_engine.h"
+#include "stage_timer.h"
+#include <stdexcept>
+
+void MBORecordView::CopyTo(MBORecord& record) const {
+    record.ts_recv.assign(ts_recv.data(), ts_recv.size());
+    record.ts_event.assign(ts_event.data(), ts_event.size());
+    record.rtype = rtype;
+    record.publisher_id = publisher_id;
+    record.instrument_id = instrument_id;
+    record.action = action;
+    record.side = side;
+    record.price = price;
+    record.size = size;
+    record.channel_id = channel_id;
+    record.order_id = order_id;
+    record.flags = flags;
+    record.ts_in_delta = ts_in_delta;
+    record.sequence = sequence;
+    record.symbol.assign(symbol.data(), symbol.size());
+}
+
+MBOEngine::MBOEngine(SnapshotCallback callback) : callback_(std::move(callback)) {
+}
+
+void MBOEngine::OnRecord(const MBORecordView& record) {
+    record.CopyTo(view_record_);
+    OnRecord(view_record_);
+}
+
+void MBOEngine::OnRecord(const MBORecord& record) {
+    if (sample_interval_ns_ > 0) {
+        SampleRecord(record);
+        return;
+    }
+    
+    // Reset records clear the book and always produce an (empty) snapshot
+    if (record.action == ACTION_CLEAR) {
+        STAGE_TIMED(Apply, order_book_.Clear());
+        record_count_++;
+        
+        auto mbp_record = CreateMBPRecord(record);
+        EmitSnapshot(mbp_record);
+        return;
+    }
+    
+    // Apply record to order book
+    STAGE_TIMED(Apply, order_book_.Apply(record));
+    record_count_++;
+    
+    // Only generate MBP output for A, C, R, or T actions, or at event
+    // boundaries (F_LAST) when conflating
+    bool event_boundary = conflate_events_
+        ? record.IsLast()
+        : (record.action == ACTION_ADD || record.action == ACTION_CANCEL || record.action == ACTION_CLEAR || record.action == ACTION_TRADE);
+    if (event_boundary) {
+        if (order_book_.HasChanges() && visible_changes_only_ && !order_book_.HasVisibleChanges()) {
+            // Deep-book churn only: the snapshot would repeat the previous levels
+            order_book_.ResetChanges();
+            suppressed_count_++;
+        } else if (order_book_.HasChanges()) {
+            auto mbp_record = CreateMBPRecord(record);
+            EmitSnapshot(mbp_record);
+            order_book_.ResetChanges();
+        }
+    }
+}
+
+void MBOEngine::Finish() {
+    if (has_sample_record_) {
+        sample_row_ = CreateMBPRecord(last_sample_record_);
+        EmitSampleRows(current_bucket_ + 1, order_book_.ConsumeChangedLevels());
+    }
+}
+
+void MBOEngine::EmitSnapshot(const MBPRecord& record) {
+    EmitSnapshot(record, order_book_.ConsumeChangedLevels());
+}
+
+void MBOEngine::EmitSnapshot(const MBPRecord& record, LevelMask changed_levels) {
+    if (validate_output_) {
+        ValidateMBPRecord(record);
+    }
+    
+    callback_(snapshot_count_, record, changed_levels);
+    snapshot_count_++;
+}
+
+MBPRecord MBOEngine::CreateMBPRecord(const MBORecord& mbo_record) {
+    STAGE_TIMER(Snapshot);
+    
+    // Get current order book state
+    auto bids = order_book_.GetTopBids(MBP_LEVELS);
+    auto asks = order_book_.GetTopAsks(MBP_LEVELS);
+    
+    // Create MBP record
+    return MBPRecord::FromOrderBook(mbo_record, bids, asks);
+}
+
+void MBOEngine::ValidateMBPRecord(const MBPRecord& record) const {
+    // Basic validation checks
+    if (record.rtype != 10) {
+        throw std::runtime_error("Invalid MBP record type: " + std::to_string(record.rtype));
+    }
+    
+    if (!utils::IsValidAction(record.action)) {
+        throw std::runtime_error("Invalid action in MBP record: " + std::string(1, record.action));
+    }
+    
+    if (!utils::IsValidSide(record.side)) {
+        throw std::runtime_error("Invalid side in MBP record: " + std::string(1, record.side));
+    }
+    
+    // Validate price levels
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        // Check bid levels
+        if (record.bid_prices[i] != kUndefPrice) {
+            if (record.bid_sizes[i] == 0 || record.bid_counts[i] == 0) {
+                throw std::runtime_error("Invalid bid level " + std::to_string(i) + ": price set but size/count is 0");
+            }
+        }
+        
+        // Check ask levels
+        if (record.ask_prices[i] != kUndefPrice) {
+            if (record.ask_sizes[i] == 0 || record.ask_counts[i] == 0) {
+                throw std::runtime_error("Invalid ask level " + std::to_string(i) + ": price set but size/count is 0");
+            }
+        }
+    }
+}
+
+void MBOEngine::SampleRecord(const MBORecord& record) {
+    uint64_t bucket = utils::ParseTimestamp(record.ts_event) / sample_interval_ns_;
+    bool closes_bucket = has_sample_record_ && bucket > current_bucket_;
+    if (has_sample_record_ && !closes_bucket) {
+        bucket = current_bucket_;  // Never move back in time on out-of-order records
+    }
+    
+    // The closing bucket's row shows the book before this record, but it is
+    // only emitted once the record has applied: a rejected record moves no time
+    LevelMask closing_changes = 0;
+    if (closes_bucket) {
+        sample_row_ = CreateMBPRecord(last_sample_record_);
+        closing_changes = order_book_.ConsumeChangedLevels();
+    }
+    
+    try {
+        if (record.action == ACTION_CLEAR) {
+            STAGE_TIMED(Apply, order_book_.Clear());
+        } else {
+            STAGE_TIMED(Apply, order_book_.Apply(record));
+        }
+    } catch (...) {
+        order_book_.MarkChangedLevels(closing_changes);
+        throw;
+    }
+    record_count_++;
+    
+    if (closes_bucket) {
+        EmitSampleRows(bucket, closing_changes);
+    }
+    last_sample_record_ = record;
+    current_bucket_ = bucket;
+    has_sample_record_ = true;
+}
+
+void MBOEngine::EmitSampleRows(uint64_t next_bucket, LevelMask changed_levels) {
+    WriteSampleRow(current_bucket_, changed_levels);
+    
+    if (fill_empty_buckets_) {
+        for (uint64_t bucket = current_bucket_ + 1; bucket < next_bucket; ++bucket) {
+            WriteSampleRow(bucket, 0);   // Same book as the row before
+        }
+    }
+    
+    has_sample_record_ = false;
+}
+
+void MBOEngine::WriteSampleRow(uint64_t bucket, LevelMask changed_levels) {
+    sample_row_.ts_event = utils::FormatTimestamp((bucket + 1) * sample_interval_ns_);
+    EmitSnapshot(sample_row_, changed_levels);
+}
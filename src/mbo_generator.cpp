@@ -0,0 +1,377 @@
+#include "mbo_generator.h"
+#include "utils.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint8_t kFlagsLast = 130;   // F_LAST plus the publisher bit seen in the sample data
+constexpr uint8_t kFlagsClear = 8;
+constexpr uint64_t kMask63 = (1ULL << 63) - 1;
+constexpr uint32_t kMaxEventRecords = 64;
+
+/**
+ * Bijection on 63-bit values (xorshift-multiply rounds), so distinct
+ * counters give distinct, scattered order IDs
+ */
+uint64_t Scatter63(uint64_t x) {
+    x &= kMask63;
+    x ^= x >> 31;
+    x = (x * 0x7fb5d329728ea185ULL) & kMask63;
+    x ^= x >> 27;
+    x = (x * 0x81dadef4bc2dd44dULL) & kMask63;
+    x ^= x >> 33;
+    return x;
+}
+
+void AppendNumber(std::string& out, uint64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void AppendPrice(std::string& out, Price price) {
+    if (price == kUndefPrice) {
+        return;
+    }
+    if (price < 0) {
+        out += '-';
+        price = -price;
+    }
+    AppendNumber(out, static_cast<uint64_t>(price) / 1000000000ULL);
+    char fraction[10];
+    uint64_t nanos = static_cast<uint64_t>(price) % 1000000000ULL;
+    for (int i = 8; i >= 0; --i) {
+        fraction[i + 1] = static_cast<char>('0' + nanos % 10);
+        nanos /= 10;
+    }
+    fraction[0] = '.';
+    out.append(fraction, sizeof(fraction));
+}
+
+} // namespace
+
+OrderIdPattern ParseOrderIdPattern(const std::string& name) {
+    if (name == "sequential") {
+        return OrderIdPattern::Sequential;
+    }
+    if (name == "random") {
+        return OrderIdPattern::Random;
+    }
+    if (name == "recycled") {
+        return OrderIdPattern::Recycled;
+    }
+    throw std::invalid_argument("Unknown order ID pattern: " + name + " (expected sequential, random or recycled)");
+}
+
+void GeneratorConfig::Validate() const {
+    if (instruments == 0) {
+        throw std::invalid_argument("Generator needs at least one instrument");
+    }
+    if (add_weight < 0 || cancel_weight < 0 || modify_weight < 0 || trade_weight < 0 ||
+        add_weight + cancel_weight + modify_weight + trade_weight <= 0) {
+        throw std::invalid_argument("Action weights must be non-negative and not all zero");
+    }
+    if (tick_size <= 0 || depth == 0) {
+        throw std::invalid_argument("Tick size and depth must be positive");
+    }
+    if (start_price <= static_cast<Price>(depth + 1) * tick_size) {
+        throw std::invalid_argument("Start price must exceed depth + 1 ticks");
+    }
+    if (target_orders == 0 || max_size == 0) {
+        throw std::invalid_argument("Target orders and max size must be positive");
+    }
+    if (walk_probability < 0 || walk_probability > 1 || burst_probability < 0 || burst_probability > 1) {
+        throw std::invalid_argument("Probabilities must be within [0, 1]");
+    }
+    if (mean_event_records < 1 || mean_gap_ns == 0 || burst_speedup == 0) {
+        throw std::invalid_argument("Mean event records must be >= 1; gap and burst speedup must be positive");
+    }
+}
+
+MBOGenerator::MBOGenerator(const GeneratorConfig& config)
+    : config_(config), rng_(config.seed), clears_left_(config.instruments), ts_event_(config.start_time_ns) {
+    config_.Validate();
+    total_weight_ = config_.add_weight + config_.cancel_weight + config_.modify_weight + config_.trade_weight;
+    remaining_ = config_.records;
+    
+    instruments_.resize(config_.instruments);
+    for (uint32_t i = 0; i < config_.instruments; ++i) {
+        Instrument& instrument = instruments_[i];
+        instrument.instrument_id = config_.first_instrument_id + i;
+        instrument.symbol = i == 0 ? config_.symbol : config_.symbol + std::to_string(i);
+        instrument.mid = config_.start_price;
+        instrument.orders.reserve(config_.target_orders);
+    }
+}
+
+bool MBOGenerator::Next(MBORecord& record) {
+    if (pending_.empty()) {
+        if (clears_left_ > 0) {
+            // One reset per instrument opens the stream, as in recorded sessions
+            const Instrument& instrument = instruments_[config_.instruments - clears_left_--];
+            record = MakeRecord(instrument, ACTION_CLEAR, NEUTRAL_SIDE, kUndefPrice, 0, 0);
+            record.flags = kFlagsClear;
+            record.ts_event = utils::FormatTimestamp(ts_event_);
+            record.ts_recv = record.ts_event;
+            record.ts_in_delta = 0;
+            generated_++;
+            return true;
+        }
+        if (remaining_ == 0) {
+            return false;
+        }
+        GenerateEvent();
+    }
+    
+    record = std::move(pending_.front());
+    pending_.pop_front();
+    generated_++;
+    return true;
+}
+
+size_t MBOGenerator::RestingOrders() const {
+    size_t orders = 0;
+    for (const auto& instrument : instruments_) {
+        orders += instrument.orders.size();
+    }
+    return orders;
+}
+
+void MBOGenerator::GenerateEvent() {
+    Instrument& instrument = instruments_[Uniform(instruments_.size())];
+    std::vector<MBORecord> event;
+    
+    if (UniformReal() < config_.walk_probability) {
+        MoveMid(instrument, event);
+    }
+    
+    // Geometric number of order actions with the configured mean
+    uint32_t actions = 1;
+    double more = 1.0 - 1.0 / config_.mean_event_records;
+    while (actions < kMaxEventRecords && UniformReal() < more) {
+        actions++;
+    }
+    
+    for (uint32_t i = 0; i < actions; ++i) {
+        double roll = UniformReal() * total_weight_;
+        bool empty = instrument.orders.empty();
+        if (roll < config_.add_weight) {
+            if (instrument.orders.size() >= config_.target_orders) {
+                CancelOrder(instrument, event);
+            } else {
+                AddOrder(instrument, event);
+            }
+        } else if (empty) {
+            AddOrder(instrument, event);
+        } else if (roll < config_.add_weight + config_.cancel_weight) {
+            CancelOrder(instrument, event);
+        } else if (roll < config_.add_weight + config_.cancel_weight + config_.modify_weight) {
+            ModifyOrder(instrument, event);
+        } else {
+            TradeAtTouch(instrument, event);
+        }
+    }
+    
+    // Stop exactly at the requested count; the cut event still ends with F_LAST
+    if (event.size() > remaining_) {
+        event.resize(remaining_);
+    }
+    remaining_ -= event.size();
+    
+    int32_t ts_in_delta = static_cast<int32_t>(165000 + Uniform(2000));
+    std::string ts_event = utils::FormatTimestamp(ts_event_);
+    std::string ts_recv = utils::FormatTimestamp(ts_event_ + ts_in_delta);
+    for (size_t i = 0; i < event.size(); ++i) {
+        MBORecord& record = event[i];
+        record.ts_event = ts_event;
+        record.ts_recv = ts_recv;
+        record.ts_in_delta = ts_in_delta;
+        record.flags = i + 1 == event.size() ? kFlagsLast : 0;
+        pending_.push_back(std::move(record));
+    }
+    
+    // Exponential gap to the next event, much shorter inside a burst
+    double mean_gap = static_cast<double>(config_.mean_gap_ns);
+    if (burst_events_left_ > 0) {
+        burst_events_left_--;
+        mean_gap /= config_.burst_speedup;
+    } else if (UniformReal() < config_.burst_probability) {
+        burst_events_left_ = config_.burst_events;
+    }
+    ts_event_ += 1 + static_cast<uint64_t>(-std::log(1.0 - UniformReal()) * mean_gap);
+}
+
+void MBOGenerator::AddOrder(Instrument& instrument, std::vector<MBORecord>& event) {
+    char side = (rng_() & 1) ? BID_SIDE : ASK_SIDE;
+    RestingOrder order{NewOrderId(), RandomPrice(instrument, side), RandomSize(), side};
+    instrument.orders.push_back(order);
+    event.push_back(MakeRecord(instrument, ACTION_ADD, order.side, order.price, order.size, order.id));
+}
+
+void MBOGenerator::CancelOrder(Instrument& instrument, std::vector<MBORecord>& event) {
+    size_t index = Uniform(instrument.orders.size());
+    const RestingOrder& order = instrument.orders[index];
+    event.push_back(MakeRecord(instrument, ACTION_CANCEL, order.side, order.price, order.size, order.id));
+    RemoveOrder(instrument, index);
+}
+
+void MBOGenerator::ModifyOrder(Instrument& instrument, std::vector<MBORecord>& event) {
+    RestingOrder& order = instrument.orders[Uniform(instrument.orders.size())];
+    if (rng_() & 1) {
+        order.price = RandomPrice(instrument, order.side);
+    }
+    order.size = RandomSize();
+    event.push_back(MakeRecord(instrument, ACTION_MODIFY, order.side, order.price, order.size, order.id));
+}
+
+void MBOGenerator::TradeAtTouch(Instrument& instrument, std::vector<MBORecord>& event) {
+    // Aggress against the best order of a random side (the other one if that side is empty)
+    char side = (rng_() & 1) ? BID_SIDE : ASK_SIDE;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        size_t best = instrument.orders.size();
+        for (size_t i = 0; i < instrument.orders.size(); ++i) {
+            const RestingOrder& order = instrument.orders[i];
+            if (order.side != side) {
+                continue;
+            }
+            if (best == instrument.orders.size() ||
+                (side == BID_SIDE ? order.price > instrument.orders[best].price : order.price < instrument.orders[best].price)) {
+                best = i;
+            }
+        }
+        if (best != instrument.orders.size()) {
+            Fill(instrument, best, event);
+            return;
+        }
+        side = side == BID_SIDE ? ASK_SIDE : BID_SIDE;
+    }
+}
+
+void MBOGenerator::MoveMid(Instrument& instrument, std::vector<MBORecord>& event) {
+    bool up = (rng_() & 1) != 0;
+    if (!up && instrument.mid - static_cast<Price>(config_.depth + 2) * config_.tick_size <= 0) {
+        up = true;   // Keep every order price positive
+    }
+    instrument.mid += up ? config_.tick_size : -config_.tick_size;
+    
+    // Orders now at or through the mid are swept; walk backwards so swap-removal
+    // only moves already checked orders
+    for (size_t i = instrument.orders.size(); i-- > 0;) {
+        const RestingOrder& order = instrument.orders[i];
+        bool crossed = order.side == ASK_SIDE ? order.price <= instrument.mid : order.price >= instrument.mid;
+        if (crossed) {
+            Fill(instrument, i, event);
+        }
+    }
+}
+
+void MBOGenerator::Fill(Instrument& instrument, size_t index, std::vector<MBORecord>& event) {
+    // Trade (aggressor side), fill of the resting order, then its removal
+    const RestingOrder& order = instrument.orders[index];
+    char aggressor = order.side == BID_SIDE ? ASK_SIDE : BID_SIDE;
+    event.push_back(MakeRecord(instrument, ACTION_TRADE, aggressor, order.price, order.size, 0));
+    event.push_back(MakeRecord(instrument, ACTION_FILL, order.side, order.price, order.size, order.id));
+    event.push_back(MakeRecord(instrument, ACTION_CANCEL, order.side, order.price, order.size, order.id));
+    RemoveOrder(instrument, index);
+}
+
+void MBOGenerator::RemoveOrder(Instrument& instrument, size_t index) {
+    if (config_.order_ids == OrderIdPattern::Recycled) {
+        free_ids_.push_back(instrument.orders[index].id);
+    }
+    instrument.orders[index] = instrument.orders.back();
+    instrument.orders.pop_back();
+}
+
+OrderID MBOGenerator::NewOrderId() {
+    switch (config_.order_ids) {
+        case OrderIdPattern::Random:
+            return Scatter63(next_id_++);
+        case OrderIdPattern::Recycled:
+            if (!free_ids_.empty()) {
+                OrderID id = free_ids_.back();
+                free_ids_.pop_back();
+                return id;
+            }
+            return next_id_++;
+        case OrderIdPattern::Sequential:
+        default:
+            return next_id_++;
+    }
+}
+
+MBORecord MBOGenerator::MakeRecord(const Instrument& instrument, char action, char side, Price price, Size size,
+                                   OrderID order_id) {
+    MBORecord record;
+    record.rtype = 160;
+    record.publisher_id = 2;
+    record.instrument_id = instrument.instrument_id;
+    record.action = action;
+    record.side = side;
+    record.price = price;
+    record.size = size;
+    record.channel_id = 0;
+    record.order_id = order_id;
+    record.flags = 0;
+    record.ts_in_delta = 0;
+    record.sequence = action == ACTION_CLEAR ? 0 : ++sequence_;
+    record.symbol = instrument.symbol;
+    return record;
+}
+
+Price MBOGenerator::RandomPrice(const Instrument& instrument, char side) {
+    // The nearer of two uniform draws, so the book thins out away from the touch
+    Price ticks = 1 + static_cast<Price>(std::min(Uniform(config_.depth), Uniform(config_.depth)));
+    Price offset = ticks * config_.tick_size;
+    return side == BID_SIDE ? instrument.mid - offset : instrument.mid + offset;
+}
+
+Size MBOGenerator::RandomSize() {
+    return static_cast<Size>(1 + Uniform(config_.max_size));
+}
+
+namespace mbo_generator {
+
+const char* const kCSVHeader =
+    "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol";
+
+void AppendCSV(const MBORecord& record, std::string& out) {
+    out += record.ts_recv;
+    out += ',';
+    out += record.ts_event;
+    out += ',';
+    AppendNumber(out, record.rtype);
+    out += ',';
+    AppendNumber(out, record.publisher_id);
+    out += ',';
+    AppendNumber(out, record.instrument_id);
+    out += ',';
+    out += record.action;
+    out += ',';
+    out += record.side;
+    out += ',';
+    AppendPrice(out, record.price);
+    out += ',';
+    AppendNumber(out, record.size);
+    out += ',';
+    AppendNumber(out, record.channel_id);
+    out += ',';
+    AppendNumber(out, record.order_id);
+    out += ',';
+    AppendNumber(out, record.flags);
+    out += ',';
+    if (record.ts_in_delta < 0) {
+        out += '-';
+    }
+    AppendNumber(out, static_cast<uint64_t>(std::abs(static_cast<int64_t>(record.ts_in_delta))));
+    out += ',';
+    AppendNumber(out, record.sequence);
+    out += ',';
+    out += record.symbol;
+    out += '\n';
+}
+
+} // namespace mbo_generator
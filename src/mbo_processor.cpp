@@ -1,20 +1,63 @@
 #include "mbo_processor.h"
+#include "gzip_stream.h"
+#include "line_reader.h"
+#include "stage_timer.h"
 #include <iostream>
 #include <stdexcept>
 #include <chrono>
+#include <filesystem>
+#include <unistd.h>
 
-MBOProcessor::MBOProcessor(const std::string& output_filename) {
+MBOProcessor::MBOProcessor(const std::string& output_filename, const OutputOptions& output_options)
+    : engine_([this](uint64_t index, const MBPRecord& record, LevelMask changed_levels) {
+          WriteMBPRecord(index, record, changed_levels);
+      }),
+      output_buffer_size_(output_options.buffer_size),
+      output_filename_(output_filename) {
     // Enable fast I/O for better performance
     utils::EnableFastIO();
     
-    // Open output file
-    output_file_.open(output_filename);
-    if (!output_file_.is_open()) {
-        throw std::runtime_error("Failed to open output file: " + output_filename);
+    if (output_filename == "-") {
+        if (output_options.format != OutputFormat::CSV) {
+            throw std::invalid_argument("Only CSV output can be written to stdout");
+        }
+        // Keep stdout clean for the data stream
+        report_stream_ = &std::cerr;
     }
     
-    // Initialize output
-    InitializeOutput();
+    if (output_options.format != OutputFormat::CSV) {
+        // Non-CSV encodings own their file and framing
+        sink_ = MakeMBPSink(output_filename, output_options);
+    } else {
+        // Open output file; gzip output always goes through the writer thread,
+        // which is where compression happens
+        bool gzip_output = utils::IsGzipPath(output_filename);
+        if (output_options.async_buffers > 0 || gzip_output) {
+            async_writer_ = std::make_unique<AsyncFileWriter>(output_filename, output_options.async_buffers,
+                                                              output_buffer_size_,
+                                                              gzip_output ? 0 : output_options.preallocate_bytes);
+        } else if (output_filename == "-") {
+            output_to_stdout_ = true;
+        } else {
+            output_file_.open(output_filename);
+            if (!output_file_.is_open()) {
+                throw std::runtime_error("Failed to open output file: " + output_filename);
+            }
+        }
+        output_buffer_.reserve(output_buffer_size_);
+        output_buffer_bytes_.Set(output_buffer_.capacity());
+        
+        // Initialize output
+        InitializeOutput();
+        
+        if (output_options.format_threads > 0) {
+            // Header goes out first; rows then arrive from the sequencer thread
+            FlushOutput();
+            parallel_formatter_ = std::make_unique<ParallelRowFormatter>(
+                output_options.format_threads, PARALLEL_FORMAT_BATCH_ROWS,
+                [this](std::string& chunk) { WriteChunk(chunk); });
+        }
+    }
     
     // Start performance monitoring
     if (enable_performance_monitoring_) {
@@ -23,85 +66,264 @@ MBOProcessor::MBOProcessor(const std::string& output_filename) {
 }
 
 MBOProcessor::~MBOProcessor() {
+    if (hw_counters_) {
+        stage_timer::AttachHwCounters(nullptr);   // Still attached if processing threw
+    }
     try {
-        FlushOutput();
+        Close();
         if (enable_performance_monitoring_) {
             ReportFinalStats();
         }
+        if (!stage_report_file_.empty()) {
+            stage_timer::WriteJson(stage_report_file_);
+        }
+        if (metrics_exporter_ && !metrics_exporter_->TryWrite(CollectMetrics(true))) {
+            std::cerr << "Metrics export: " << metrics_exporter_->Failures() << " writes failed" << std::endl;
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error during cleanup: " << e.what() << std::endl;
     }
 }
 
+void MBOProcessor::Close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;   // A failed close is not retried by the destructor
+    
+    engine_.Finish();
+    FlushOutput();
+    if (sink_) {
+        sink_->Close();
+    }
+    if (parallel_formatter_) {
+        parallel_formatter_->Finish();
+    }
+    if (async_writer_) {
+        async_writer_->Close();
+    }
+    if (output_file_.is_open()) {
+        output_file_.close();
+        if (output_file_.fail()) {
+            throw std::runtime_error("Failed to write output file: " + output_filename_);
+        }
+    }
+}
+
 void MBOProcessor::ProcessFile(const std::string& input_filename) {
-    std::ifstream input_file(input_filename);
-    if (!input_file.is_open()) {
-        throw std::runtime_error("Failed to open input file: " + input_filename);
+    STAGE_THREAD_NAME("book");
+    StartRssSampling();
+    StartHwCounters();
+    LineReader input(input_filename);
+    
+    // Push buffered rows downstream whenever we may block waiting for input
+    if (flush_interval_ns_ > 0) {
+        input.SetBeforeRead([this] { FlushOutput(); });
     }
     
-    std::string line;
+    std::string_view line;
     
     // Skip header line
-    if (!std::getline(input_file, line)) {
+    if (!input.ReadLine(line)) {
         throw std::runtime_error("Input file is empty or cannot be read");
     }
     
     // Process each line
-    while (std::getline(input_file, line)) {
+    while (input.ReadLine(line)) {
         try {
-            auto record = MBORecord::Parse(line);
+            uint64_t start_ticks = enable_performance_monitoring_ ? utils::CycleClock::Now() : 0;
+            auto record = STAGE_TIMED(Parse, MBORecord::Parse(line));
             ProcessRecord(record);
             
             if (enable_performance_monitoring_) {
+                performance_monitor_.RecordLatency(utils::CycleClock::Now() - start_ticks);
                 performance_monitor_.RecordProcessed();
-                UpdatePerformanceStats();
             }
         } catch (const std::exception& e) {
-            std::cerr << "Error processing line " << (record_count_ + 1) << ": " << e.what() << std::endl;
+            std::cerr << "Error processing line " << (engine_.RecordCount() + 1) << ": " << e.what() << std::endl;
+            records_rejected_++;
             // Continue processing other records
         }
+        PollMetrics(input.BytesRead());
     }
     
+    // Emit the last partial bucket
+    engine_.Finish();
+    
     // Final flush
     FlushOutput();
+    StopHwCounters();
 }
 
-void MBOProcessor::ProcessRecord(const MBORecord& record) {
-    // Handle special cases first
-    if (HandleSpecialCase(record)) {
-        return;
-    }
+void MBOProcessor::ProcessStream(const std::string& source, const StreamOptions& options) {
+    StartRssSampling();
+    StartHwCounters();
+    MBOStreamReader input(source, options);
+    MBORecord record;
+    StreamStatus status;
     
-    // Apply record to order book
-    order_book_.Apply(record);
-    record_count_++;
-    
-    // Only generate MBP output for A, C, R, or T actions
-    if (record.action == ACTION_ADD || record.action == ACTION_CANCEL || record.action == ACTION_CLEAR || record.action == ACTION_TRADE) {
-        if (order_book_.HasChanges()) {
-            auto mbp_record = CreateMBPRecord(record);
-            WriteMBPRecord(mbp_record);
-            order_book_.ResetChanges();
-            mbp_record_count_++;
+    while ((status = input.Next(record)) != StreamStatus::End) {
+        if (status == StreamStatus::Malformed) {
+            std::cerr << "Error processing record " << (engine_.RecordCount() + 1) << ": " << input.Error() << std::endl;
+            records_rejected_++;
+            PollMetrics(input.BytesRead());
+            continue;
+        }
+        try {
+            uint64_t start_ticks = enable_performance_monitoring_ ? utils::CycleClock::Now() : 0;
+            uint64_t rows_before = engine_.SnapshotCount();
+            ProcessRecord(record);
+            
+            // Publish immediately; a buffered row is not yet visible downstream
+            if (engine_.SnapshotCount() != rows_before) {
+                FlushOutput();
+                stream_latency_.Record(utils::MonotonicNanos() - input.ReceiveTime());
+            }
             
             if (enable_performance_monitoring_) {
-                performance_monitor_.MBPRecordGenerated();
+                performance_monitor_.RecordLatency(utils::CycleClock::Now() - start_ticks);
+                performance_monitor_.RecordProcessed();
             }
+        } catch (const std::exception& e) {
+            std::cerr << "Error processing record " << (engine_.RecordCount() + 1) << ": " << e.what() << std::endl;
+            records_rejected_++;
         }
+        PollMetrics(input.BytesRead());
+    }
+    
+    engine_.Finish();
+    FlushOutput();
+    StopHwCounters();
+}
+
+void MBOProcessor::StartRssSampling() {
+    if (enable_performance_monitoring_ && !rss_sampler_) {
+        rss_sampler_ = std::make_unique<memory_accounting::RssSampler>();
+    }
+}
+
+void MBOProcessor::StartHwCounters() {
+    if (!hw_counters_enabled_) {
+        return;
+    }
+    // perf_event counters follow the thread that opened them
+    hw_counters_ = std::make_unique<HwCounters>();
+    stage_timer::AttachHwCounters(hw_counters_.get());
+    hw_start_ = hw_counters_->Read();
+}
+
+void MBOProcessor::StopHwCounters() {
+    if (!hw_counters_) {
+        return;
     }
+    hw_total_ += hw_counters_->Read() - hw_start_;
+    stage_timer::AttachHwCounters(nullptr);
+}
+
+void MBOProcessor::SetMetricsOutput(const std::vector<std::string>& paths, uint64_t interval_ns) {
+    metrics_exporter_ = std::make_unique<MetricsExporter>(paths, interval_ns);
+    metrics_exporter_->Write(CollectMetrics(false));
 }
 
-void MBOProcessor::WriteMBPRecord(const MBPRecord& record) {
-    if (validate_output_) {
-        ValidateMBPRecord(record);
+void MBOProcessor::PollMetrics(uint64_t bytes_in) {
+    if (!metrics_exporter_) {
+        return;
+    }
+    bytes_in_ = bytes_in;
+    if ((++metrics_polls_ & (METRICS_POLL_RECORDS - 1)) == 0 && metrics_exporter_->Due()) {
+        // A dashboard side channel must not stop the conversion
+        metrics_exporter_->TryWrite(CollectMetrics(false));
+    }
+}
+
+RunMetrics MBOProcessor::CollectMetrics(bool complete) const {
+    auto stats = GetStats();
+    auto book = engine_.Book().GetStatistics();
+    
+    RunMetrics metrics;
+    metrics.complete = complete;
+    metrics.records_processed = stats.records_processed;
+    metrics.records_rejected = stats.records_rejected;
+    metrics.rows_written = stats.mbp_records_generated;
+    metrics.rows_suppressed = stats.mbp_records_suppressed;
+    metrics.elapsed_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() -
+                                                            performance_monitor_.start_time_).count();
+    metrics.bytes_in = bytes_in_;
+    if (sink_) {
+        // Encoders buffer internally; the file size is what has reached the disk
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(output_filename_, error);
+        metrics.bytes_out = error ? 0 : size;
+    } else {
+        metrics.bytes_out = bytes_out_.load(std::memory_order_relaxed);
+    }
+    metrics.bid_levels = book.total_bid_levels;
+    metrics.ask_levels = book.total_ask_levels;
+    metrics.resting_orders = book.total_orders;
+    metrics.rss_bytes = memory_accounting::ReadRssBytes();
+    metrics.metrics_write_errors = metrics_exporter_ ? metrics_exporter_->Failures() : 0;
+    
+    const utils::LatencyHistogram& latency = performance_monitor_.Latency();
+    if (latency.Count() > 0) {
+        double ns_per_tick = utils::CycleClock::NanosPerTick();
+        metrics.latency_p50_ns = latency.Percentile(0.50) * ns_per_tick;
+        metrics.latency_p99_ns = latency.Percentile(0.99) * ns_per_tick;
+        metrics.latency_max_ns = latency.Max() * ns_per_tick;
+    }
+    
+    // Other threads' tables are only safe to read once they have finished
+    if (complete) {
+        metrics.stages = stage_timer::CollectTotals();
+    } else if (stage_timer::kEnabled) {
+        metrics.stages.push_back(stage_timer::LocalTotals());
+    }
+    return metrics;
+}
+
+void MBOProcessor::ProcessRecord(const MBORecord& record) {
+    if (shm_publisher_ && (!shm_instrument_known_ || record.instrument_id != shm_instrument_id_)) {
+        if (shm_instrument_known_) {
+            throw std::invalid_argument("Instrument " + std::to_string(record.instrument_id) +
+                                        " rejected: the shared-memory book holds instrument " +
+                                        std::to_string(shm_instrument_id_) + " only");
+        }
+        shm_instrument_id_ = record.instrument_id;
+        shm_instrument_known_ = true;
+    }
+    engine_.OnRecord(record);
+}
+
+void MBOProcessor::WriteMBPRecord(uint64_t index, const MBPRecord& record, LevelMask changed_levels) {
+    if (enable_performance_monitoring_) {
+        performance_monitor_.MBPRecordGenerated();
+    }
+    
+    if (shm_publisher_) {
+        shm_publisher_->Publish(record);
+    }
+    
+    if (sink_) {
+        STAGE_TIMED(Format, sink_->Write(index, record, changed_levels));
+        return;
+    }
+    
+    if (parallel_formatter_) {
+        // Workers find changed levels by comparing consecutive rows themselves
+        parallel_formatter_->Push(index, record);
+        if (flush_interval_ns_ > 0) {
+            FlushIfDue();
+        }
+        return;
     }
     
     // Add index and record to output buffer
-    output_buffer_ += std::to_string(mbp_record_count_) + record.ToCSV() + '\n';
+    STAGE_TIMED(Format, row_formatter_.AppendRow(index, record, changed_levels, output_buffer_));
     
     // Flush if buffer is full
-    if (output_buffer_.size() >= OUTPUT_BUFFER_SIZE) {
+    if (output_buffer_.size() >= output_buffer_size_) {
         FlushOutput();
+    } else if (flush_interval_ns_ > 0) {
+        FlushIfDue();
     }
 }
 
@@ -117,28 +339,60 @@ void MBOProcessor::WriteHeader() {
     
     header += ",symbol,order_id\n";
     
-    output_file_ << header;
+    output_buffer_ += header;
 }
 
 void MBOProcessor::FlushOutput() {
-    if (!output_buffer_.empty()) {
-        output_file_.write(output_buffer_.data(), output_buffer_.size());
-        output_buffer_.clear();
+    if (sink_) {
+        STAGE_TIMED(Write, sink_->Flush());
+        return;
+    }
+    
+    if (parallel_formatter_) {
+        parallel_formatter_->Flush();
+        return;
+    }
+    
+    WriteChunk(output_buffer_);
+    output_buffer_.clear();
+    output_buffer_bytes_.Set(output_buffer_.capacity());
+}
+
+void MBOProcessor::FlushIfDue() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_flush_time_ >= std::chrono::nanoseconds(flush_interval_ns_)) {
+        FlushOutput();
+        last_flush_time_ = now;
+    }
+}
+
+void MBOProcessor::WriteChunk(std::string& chunk) {
+    STAGE_TIMER(Write);
+    bytes_out_.fetch_add(chunk.size(), std::memory_order_relaxed);
+    if (async_writer_) {
+        async_writer_->Submit(chunk);
+    } else if (output_to_stdout_) {
+        utils::WriteFully(STDOUT_FILENO, chunk.data(), chunk.size());
+    } else if (!chunk.empty()) {
+        output_file_.write(chunk.data(), chunk.size());
     }
 }
 
 MBOProcessor::ProcessingStats MBOProcessor::GetStats() const {
     ProcessingStats stats{};
-    stats.records_processed = record_count_;
-    stats.mbp_records_generated = mbp_record_count_;
+    stats.records_processed = engine_.RecordCount();
+    stats.mbp_records_generated = engine_.SnapshotCount();
+    stats.mbp_records_suppressed = engine_.SuppressedCount();
+    stats.records_rejected = records_rejected_;
     
     // Calculate processing time and rate
     auto now = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - performance_monitor_.start_time_);
-    stats.processing_time_ms = duration.count();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(now - performance_monitor_.start_time_);
+    stats.processing_time_ms = duration.count() / 1000000;
     
-    if (stats.processing_time_ms > 0) {
-        stats.records_per_second = (record_count_ * 1000.0) / stats.processing_time_ms;
+    // Rate from nanoseconds, so sub-millisecond runs still report one
+    if (duration.count() > 0) {
+        stats.records_per_second = stats.records_processed * 1e9 / duration.count();
     }
     
     return stats;
@@ -148,99 +402,48 @@ void MBOProcessor::InitializeOutput() {
     WriteHeader();
 }
 
-MBPRecord MBOProcessor::CreateMBPRecord(const MBORecord& mbo_record) {
-    // Get current order book state
-    auto bids = order_book_.GetTopBids(MBP_LEVELS);
-    auto asks = order_book_.GetTopAsks(MBP_LEVELS);
+void MBOProcessor::ReportFinalStats() {
+    auto stats = GetStats();
+    std::ostream& out = *report_stream_;
     
-    // Create MBP record
-    return MBPRecord::FromOrderBook(mbo_record, bids, asks);
-}
-
-void MBOProcessor::ValidateMBPRecord(const MBPRecord& record) const {
-    // Basic validation checks
-    if (record.rtype != 10) {
-        throw std::runtime_error("Invalid MBP record type: " + std::to_string(record.rtype));
+    out << "\n=== Processing Complete ===\n";
+    out << "Records processed: " << stats.records_processed << "\n";
+    out << "MBP records generated: " << stats.mbp_records_generated << "\n";
+    if (visible_changes_only_) {
+        out << "MBP records suppressed (no visible change): " << stats.mbp_records_suppressed << "\n";
     }
-    
-    if (!utils::IsValidAction(record.action)) {
-        throw std::runtime_error("Invalid action in MBP record: " + std::string(1, record.action));
+    if (stats.records_rejected > 0) {
+        out << "Records rejected: " << stats.records_rejected << "\n";
     }
-    
-    if (!utils::IsValidSide(record.side)) {
-        throw std::runtime_error("Invalid side in MBP record: " + std::string(1, record.side));
+    out << "Processing time: " << stats.processing_time_ms << "ms\n";
+    out << "Processing rate: " << stats.records_per_second << " records/sec\n";
+    performance_monitor_.ReportLatency(out);
+    if (rss_sampler_) {
+        rss_sampler_->Stop();
+        performance_monitor_.UpdateMemoryUsage(rss_sampler_->PeakBytes());
     }
-    
-    // Validate price levels
-    for (int i = 0; i < MBP_LEVELS; ++i) {
-        // Check bid levels
-        if (record.bid_prices[i] != kUndefPrice) {
-            if (record.bid_sizes[i] == 0 || record.bid_counts[i] == 0) {
-                throw std::runtime_error("Invalid bid level " + std::to_string(i) + ": price set but size/count is 0");
-            }
-        }
-        
-        // Check ask levels
-        if (record.ask_prices[i] != kUndefPrice) {
-            if (record.ask_sizes[i] == 0 || record.ask_counts[i] == 0) {
-                throw std::runtime_error("Invalid ask level " + std::to_string(i) + ": price set but size/count is 0");
-            }
-        }
+    memory_accounting::Report(out, rss_sampler_.get());
+    if (hw_counters_) {
+        hw_counters_->Report(out, "Hardware counters (book thread)", hw_total_, stats.records_processed);
     }
-}
-
-bool MBOProcessor::HandleSpecialCase(const MBORecord& record) {
-    // Process all records including reset records
-    // Reset records should generate MBP records with empty order book
-    // We don't skip any records - all should be processed
-    // For reset records, we need to clear the order book and generate an MBP record
-    if (record.action == ACTION_CLEAR) {
-        order_book_.Clear();
-        record_count_++;
-        
-        // Generate MBP record for reset
-        auto mbp_record = CreateMBPRecord(record);
-        WriteMBPRecord(mbp_record);
-        mbp_record_count_++;
-        
-        if (enable_performance_monitoring_) {
-            performance_monitor_.MBPRecordGenerated();
-        }
-        
-        return true;  // Skip normal processing since we handled it here
+    stage_timer::Report(out);
+    if (stream_latency_.Count() > 0) {
+        stream_latency_.Report(out, "Receive-to-output latency");
     }
     
-    return false;
-}
-
-void MBOProcessor::UpdatePerformanceStats() {
-    // Update memory usage (simplified - in production, use proper memory tracking)
-    size_t estimated_memory = order_book_.GetStatistics().total_orders * sizeof(OrderID) * 2;
-    performance_monitor_.UpdateMemoryUsage(estimated_memory);
-}
-
-void MBOProcessor::ReportFinalStats() {
-    auto stats = GetStats();
-    
-    std::cout << "\n=== Processing Complete ===\n";
-    std::cout << "Records processed: " << stats.records_processed << "\n";
-    std::cout << "MBP records generated: " << stats.mbp_records_generated << "\n";
-    std::cout << "Processing time: " << stats.processing_time_ms << "ms\n";
-    std::cout << "Processing rate: " << stats.records_per_second << " records/sec\n";
-    
     // Order book statistics
-    auto ob_stats = order_book_.GetStatistics();
-    std::cout << "Final order book state:\n";
-    std::cout << "  Bid levels: " << ob_stats.total_bid_levels << "\n";
-    std::cout << "  Ask levels: " << ob_stats.total_ask_levels << "\n";
-    std::cout << "  Total orders: " << ob_stats.total_orders << "\n";
+    auto ob_stats = engine_.Book().GetStatistics();
+    out << "Final order book state:\n";
+    out << "  Bid levels: " << ob_stats.total_bid_levels << "\n";
+    out << "  Ask levels: " << ob_stats.total_ask_levels << "\n";
+    out << "  Total orders: " << ob_stats.total_orders << "\n";
     
     if (ob_stats.best_bid != kUndefPrice) {
-        std::cout << "  Best bid: " << utils::FormatPrice(ob_stats.best_bid) << "\n";
+        out << "  Best bid: " << utils::FormatPrice(ob_stats.best_bid) << "\n";
     }
     if (ob_stats.best_ask != kUndefPrice) {
-        std::cout << "  Best ask: " << utils::FormatPrice(ob_stats.best_ask) << "\n";
+        out << "  Best ask: " << utils::FormatPrice(ob_stats.best_ask) << "\n";
     }
     
-    std::cout << "==========================\n";
+    out << "==========================\n";
 } 
\ No newline at end of file
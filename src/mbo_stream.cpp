@@ -0,0 +1,216 @@
+#include "mbo_stream.h"
+#include "mbo_binary.h"
+#include "utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::string_view kUnixPrefix = "unix:";
+
+} // namespace
+
+MBOStreamReader::MBOStreamReader(const std::string& source, const StreamOptions& options)
+    : options_(options), buffer_(std::max<size_t>(options.buffer_size, 4096)) {
+    if (source.compare(0, kUnixPrefix.size(), kUnixPrefix) == 0) {
+        OpenSocket(source.substr(kUnixPrefix.size()));
+    } else if (source == "-") {
+        fd_ = STDIN_FILENO;
+    } else {
+        // Opening a FIFO blocks until the writer side is opened
+        fd_ = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open input stream: " + source + ": " + std::strerror(errno));
+        }
+        owns_fd_ = true;
+    }
+    
+    // O_NONBLOCK is shared with every process holding the file description
+    // (e.g. the shell's stdin), so the original flags are put back on close
+    if (options_.busy_poll) {
+        int flags = ::fcntl(fd_, F_GETFL);
+        if (flags < 0 || ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK) != 0) {
+            throw std::runtime_error(std::string("Failed to make input non-blocking: ") + std::strerror(errno));
+        }
+        saved_flags_ = flags;
+    }
+}
+
+MBOStreamReader::~MBOStreamReader() {
+    if (saved_flags_ >= 0) {
+        ::fcntl(fd_, F_SETFL, saved_flags_);
+    }
+    if (owns_fd_) {
+        ::close(fd_);
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        ::unlink(socket_path_.c_str());
+    }
+}
+
+void MBOStreamReader::OpenSocket(const std::string& path) {
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid Unix socket path: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("Failed to create socket: ") + std::strerror(errno));
+    }
+    socket_path_ = path;
+    
+    // A stale socket file from a previous run would make bind() fail
+    ::unlink(path.c_str());
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd_, 1) != 0) {
+        throw std::runtime_error("Failed to listen on " + path + ": " + std::strerror(errno));
+    }
+    
+    do {
+        fd_ = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    } while (fd_ < 0 && errno == EINTR);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to accept on " + path + ": " + std::strerror(errno));
+    }
+    owns_fd_ = true;
+}
+
+bool MBOStreamReader::IsStreamSource(const std::string& source) {
+    if (source.compare(0, kUnixPrefix.size(), kUnixPrefix) == 0) {
+        return true;
+    }
+    struct stat info;
+    return ::stat(source.c_str(), &info) == 0 && S_ISFIFO(info.st_mode);
+}
+
+StreamStatus MBOStreamReader::Next(MBORecord& record) {
+    return options_.framing == StreamFraming::Binary ? NextBinary(record) : NextCSV(record);
+}
+
+bool MBOStreamReader::Fill() {
+    if (eof_) {
+        return false;
+    }
+    
+    // Keep the partial record at the front; grow only for oversized lines
+    if (begin_ > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    if (end_ == buffer_.size()) {
+        buffer_.resize(buffer_.size() * 2);
+    }
+    
+    while (true) {
+        ssize_t count = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+        if (count > 0) {
+            end_ += static_cast<size_t>(count);
+            bytes_read_ += static_cast<uint64_t>(count);
+            receive_time_ = utils::MonotonicNanos();
+            return true;
+        }
+        if (count == 0) {
+            eof_ = true;
+            return false;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            utils::CpuRelax();
+            continue;
+        }
+        if (errno != EINTR) {
+            throw std::runtime_error(std::string("Failed to read input stream: ") + std::strerror(errno));
+        }
+    }
+}
+
+StreamStatus MBOStreamReader::NextCSV(MBORecord& record) {
+    while (true) {
+        const char* begin = buffer_.data() + begin_;
+        const void* newline = std::memchr(begin, '\n', end_ - begin_);
+        
+        std::string_view line;
+        if (newline) {
+            line = std::string_view(begin, static_cast<const char*>(newline) - begin);
+            begin_ += line.size() + 1;
+        } else if (!Fill()) {
+            if (begin_ == end_) {
+                return StreamStatus::End;
+            }
+            // Final line without a trailing newline (Fill() may have moved it)
+            line = std::string_view(buffer_.data() + begin_, end_ - begin_);
+            begin_ = end_;
+        } else {
+            continue;
+        }
+        
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (!header_checked_) {
+            header_checked_ = true;
+            if (line.compare(0, 7, "ts_recv") == 0) {
+                continue;
+            }
+        }
+        
+        // A bad line costs that line only; the stream stays in sync at the next newline
+        try {
+            record = MBORecord::Parse(line);
+        } catch (const std::exception& e) {
+            error_ = e.what();
+            return StreamStatus::Malformed;
+        }
+        record_receive_time_ = receive_time_;
+        return StreamStatus::Record;
+    }
+}
+
+StreamStatus MBOStreamReader::NextBinary(MBORecord& record) {
+    if (!header_checked_) {
+        while (end_ - begin_ < sizeof(mbp_binary::FileHeader)) {
+            if (!Fill()) {
+                if (begin_ == end_) {
+                    return StreamStatus::End;
+                }
+                throw std::runtime_error("Truncated binary MBO stream header");
+            }
+        }
+        mbp_binary::FileHeader header;
+        std::memcpy(&header, buffer_.data() + begin_, sizeof(header));
+        symbol_ = mbo_binary::CheckHeader(header);
+        begin_ += sizeof(header);
+        header_checked_ = true;
+    }
+    
+    while (end_ - begin_ < sizeof(mbo_binary::MBOMsg)) {
+        if (!Fill()) {
+            if (begin_ == end_) {
+                return StreamStatus::End;
+            }
+            throw std::runtime_error("Truncated binary MBO record at end of stream");
+        }
+    }
+    
+    mbo_binary::MBOMsg message;
+    std::memcpy(&message, buffer_.data() + begin_, sizeof(message));
+    begin_ += sizeof(message);
+    
+    mbo_binary::Decode(message, symbol_, record);
+    record_receive_time_ = receive_time_;
+    return StreamStatus::Record;
+}
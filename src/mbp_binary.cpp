@@ -0,0 +1,174 @@
+#include "mbp_binary.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace mbp_binary {
+
+MBP10Record Encode(const MBPRecord& record) {
+    MBP10Record out{};
+    
+    out.hd.length = sizeof(MBP10Record) / 4;
+    out.hd.rtype = record.rtype;
+    out.hd.publisher_id = record.publisher_id;
+    out.hd.instrument_id = record.instrument_id;
+    out.hd.ts_event = utils::ParseTimestamp(record.ts_event);
+    out.price = record.price;
+    out.size = record.size;
+    out.action = record.action;
+    out.side = record.side;
+    out.flags = record.flags;
+    out.depth = static_cast<uint8_t>(record.depth);
+    out.ts_recv = utils::ParseTimestamp(record.ts_recv);
+    out.ts_in_delta = record.ts_in_delta;
+    out.sequence = record.sequence;
+    
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        BidAskPair& level = out.levels[i];
+        level.bid_px = record.bid_prices[i];
+        level.ask_px = record.ask_prices[i];
+        level.bid_sz = record.bid_sizes[i];
+        level.ask_sz = record.ask_sizes[i];
+        level.bid_ct = record.bid_counts[i];
+        level.ask_ct = record.ask_counts[i];
+    }
+    
+    return out;
+}
+
+MBPRecord Decode(const MBP10Record& record, const std::string& symbol) {
+    MBPRecord out;
+    
+    out.ts_recv = utils::FormatTimestamp(record.ts_recv);
+    out.ts_event = utils::FormatTimestamp(record.hd.ts_event);
+    out.rtype = record.hd.rtype;
+    out.publisher_id = record.hd.publisher_id;
+    out.instrument_id = record.hd.instrument_id;
+    out.action = record.action;
+    out.side = record.side;
+    out.depth = record.depth;
+    out.price = record.price;
+    out.size = record.size;
+    out.flags = record.flags;
+    out.ts_in_delta = record.ts_in_delta;
+    out.sequence = record.sequence;
+    out.symbol = symbol;
+    out.order_id = 0;   // Not part of the Mbp10Msg layout
+    
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        const BidAskPair& level = record.levels[i];
+        out.SetBidLevel(i, level.bid_px, level.bid_sz, level.bid_ct);
+        out.SetAskLevel(i, level.ask_px, level.ask_sz, level.ask_ct);
+    }
+    
+    return out;
+}
+
+} // namespace mbp_binary
+
+MBPBinaryWriter::MBPBinaryWriter(const std::string& filename) {
+    file_.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Failed to open output file: " + filename);
+    }
+    
+    std::memcpy(header_.magic, mbp_binary::MAGIC, sizeof(header_.magic));
+    header_.version = mbp_binary::VERSION;
+    header_.record_size = sizeof(mbp_binary::MBP10Record);
+    
+    // Placeholder header, patched with the final record count on Close()
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    buffer_.reserve(BUFFER_SIZE + sizeof(mbp_binary::MBP10Record));
+}
+
+MBPBinaryWriter::~MBPBinaryWriter() {
+    try {
+        Close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error closing binary MBP output: " << e.what() << std::endl;
+    }
+}
+
+void MBPBinaryWriter::Write(uint64_t /*index*/, const MBPRecord& record, LevelMask /*changed*/) {
+    if (header_.record_count == 0) {
+        size_t length = std::min(record.symbol.size(), sizeof(header_.symbol));
+        std::memcpy(header_.symbol, record.symbol.data(), length);
+    }
+    
+    mbp_binary::MBP10Record packed = mbp_binary::Encode(record);
+    buffer_.append(reinterpret_cast<const char*>(&packed), sizeof(packed));
+    header_.record_count++;
+    
+    if (buffer_.size() >= BUFFER_SIZE) {
+        Flush();
+    }
+}
+
+void MBPBinaryWriter::Flush() {
+    if (!buffer_.empty()) {
+        file_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+}
+
+void MBPBinaryWriter::Close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    
+    Flush();
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    file_.close();
+    if (file_.fail()) {
+        throw std::runtime_error("Failed to write binary MBP output");
+    }
+}
+
+MBPBinaryReader::MBPBinaryReader(const std::string& filename) {
+    file_.open(filename, std::ios::binary);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Failed to open input file: " + filename);
+    }
+    
+    if (!file_.read(reinterpret_cast<char*>(&header_), sizeof(header_)) ||
+        std::memcmp(header_.magic, mbp_binary::MAGIC, sizeof(header_.magic)) != 0) {
+        throw std::runtime_error("Not a binary MBP-10 file: " + filename);
+    }
+    if (header_.version != mbp_binary::VERSION || header_.record_size != sizeof(mbp_binary::MBP10Record)) {
+        throw std::runtime_error("Unsupported binary MBP-10 version in " + filename);
+    }
+    
+    // Fall back to the file size if the writer never patched the header
+    record_count_ = header_.record_count;
+    if (record_count_ == 0) {
+        file_.seekg(0, std::ios::end);
+        uint64_t file_size = static_cast<uint64_t>(file_.tellg());
+        record_count_ = (file_size - sizeof(header_)) / sizeof(mbp_binary::MBP10Record);
+    }
+}
+
+std::string MBPBinaryReader::Symbol() const {
+    return std::string(header_.symbol, strnlen(header_.symbol, sizeof(header_.symbol)));
+}
+
+mbp_binary::MBP10Record MBPBinaryReader::ReadRaw(uint64_t row) const {
+    if (row >= record_count_) {
+        throw std::out_of_range("Row " + std::to_string(row) + " out of range");
+    }
+    
+    mbp_binary::MBP10Record record;
+    file_.clear();
+    file_.seekg(sizeof(header_) + row * sizeof(record));
+    if (!file_.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        throw std::runtime_error("Failed to read row " + std::to_string(row));
+    }
+    return record;
+}
+
+MBPRecord MBPBinaryReader::Read(uint64_t row) const {
+    return mbp_binary::Decode(ReadRaw(row), Symbol());
+}
@@ -0,0 +1,441 @@
+#include "mbp_columnar.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace mbp_columnar {
+
+namespace {
+
+std::vector<ColumnInfo> BuildSchema() {
+    std::vector<ColumnInfo> schema = {
+        {"ts_recv", Encoding::Delta, ColumnKind::Timestamp},
+        {"ts_event", Encoding::Delta, ColumnKind::Timestamp},
+        {"rtype", Encoding::RLE, ColumnKind::Integer},
+        {"publisher_id", Encoding::RLE, ColumnKind::Integer},
+        {"instrument_id", Encoding::RLE, ColumnKind::Integer},
+        {"action", Encoding::RLE, ColumnKind::Char},
+        {"side", Encoding::RLE, ColumnKind::Char},
+        {"depth", Encoding::RLE, ColumnKind::Integer},
+        {"price", Encoding::Delta, ColumnKind::Price},
+        {"size", Encoding::RLE, ColumnKind::Integer},
+        {"flags", Encoding::RLE, ColumnKind::Integer},
+        {"ts_in_delta", Encoding::Plain, ColumnKind::Integer},
+        {"sequence", Encoding::Delta, ColumnKind::Integer},
+    };
+    
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        std::string level = (i < 10 ? "0" : "") + std::to_string(i);
+        for (const char* side : {"bid", "ask"}) {
+            schema.push_back({std::string(side) + "_px_" + level, Encoding::Delta, ColumnKind::Price});
+            schema.push_back({std::string(side) + "_sz_" + level, Encoding::RLE, ColumnKind::Integer});
+            schema.push_back({std::string(side) + "_ct_" + level, Encoding::RLE, ColumnKind::Integer});
+        }
+    }
+    
+    schema.push_back({"symbol", Encoding::RLE, ColumnKind::Symbol});
+    schema.push_back({"order_id", Encoding::Delta, ColumnKind::Integer});
+    return schema;
+}
+
+uint64_t ZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void PutVarint(uint64_t value, std::string& out) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+uint64_t GetVarint(const char*& pos, const char* end) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos == end) {
+            throw std::runtime_error("Truncated column data");
+        }
+        uint8_t byte = static_cast<uint8_t>(*pos++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Malformed varint in column data");
+}
+
+// Wrapping difference so deltas around kUndefPrice never overflow
+int64_t WrappingSub(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+}
+
+int64_t WrappingAdd(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+
+template <typename T>
+void PutFixed(T value, std::string& out) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T GetFixed(const char*& pos, const char* end) {
+    if (static_cast<size_t>(end - pos) < sizeof(T)) {
+        throw std::runtime_error("Truncated columnar footer");
+    }
+    T value;
+    std::memcpy(&value, pos, sizeof(value));
+    pos += sizeof(value);
+    return value;
+}
+
+} // namespace
+
+const std::vector<ColumnInfo>& Schema() {
+    static const std::vector<ColumnInfo> schema = BuildSchema();
+    return schema;
+}
+
+void EncodeColumn(Encoding encoding, const std::vector<int64_t>& values, std::string& out) {
+    switch (encoding) {
+        case Encoding::Plain:
+            for (int64_t value : values) {
+                PutVarint(ZigZag(value), out);
+            }
+            break;
+        case Encoding::Delta: {
+            int64_t previous = 0;
+            for (int64_t value : values) {
+                PutVarint(ZigZag(WrappingSub(value, previous)), out);
+                previous = value;
+            }
+            break;
+        }
+        case Encoding::RLE:
+            for (size_t i = 0; i < values.size();) {
+                size_t run = 1;
+                while (i + run < values.size() && values[i + run] == values[i]) {
+                    ++run;
+                }
+                PutVarint(ZigZag(values[i]), out);
+                PutVarint(run, out);
+                i += run;
+            }
+            break;
+    }
+}
+
+void DecodeColumn(Encoding encoding, const char* data, size_t length, uint64_t row_count, std::vector<int64_t>& out) {
+    const char* pos = data;
+    const char* end = data + length;
+    uint64_t target = out.size() + row_count;
+    
+    switch (encoding) {
+        case Encoding::Plain:
+            while (out.size() < target) {
+                out.push_back(UnZigZag(GetVarint(pos, end)));
+            }
+            break;
+        case Encoding::Delta: {
+            int64_t previous = 0;
+            while (out.size() < target) {
+                previous = WrappingAdd(previous, UnZigZag(GetVarint(pos, end)));
+                out.push_back(previous);
+            }
+            break;
+        }
+        case Encoding::RLE:
+            while (out.size() < target) {
+                int64_t value = UnZigZag(GetVarint(pos, end));
+                uint64_t run = GetVarint(pos, end);
+                if (run > target - out.size()) {
+                    throw std::runtime_error("RLE run exceeds row group size");
+                }
+                out.insert(out.end(), run, value);
+            }
+            break;
+    }
+}
+
+} // namespace mbp_columnar
+
+using namespace mbp_columnar;
+
+MBPColumnarWriter::MBPColumnarWriter(const std::string& filename, size_t row_group_size)
+    : row_group_size_(std::max<size_t>(row_group_size, 1)),
+      columns_(Schema().size()) {
+    file_.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Failed to open output file: " + filename);
+    }
+    
+    for (auto& column : columns_) {
+        column.reserve(row_group_size_);
+    }
+    
+    std::string header(MAGIC, sizeof(MAGIC));
+    PutFixed<uint16_t>(VERSION, header);
+    PutFixed<uint16_t>(0, header);
+    AppendBytes(header);
+}
+
+MBPColumnarWriter::~MBPColumnarWriter() {
+    try {
+        Close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error closing columnar MBP output: " << e.what() << std::endl;
+    }
+}
+
+void MBPColumnarWriter::Write(uint64_t /*index*/, const MBPRecord& record, LevelMask /*changed*/) {
+    size_t column = 0;
+    auto push = [&](int64_t value) { columns_[column++].push_back(value); };
+    
+    push(static_cast<int64_t>(utils::ParseTimestamp(record.ts_recv)));
+    push(static_cast<int64_t>(utils::ParseTimestamp(record.ts_event)));
+    push(record.rtype);
+    push(record.publisher_id);
+    push(record.instrument_id);
+    push(record.action);
+    push(record.side);
+    push(record.depth);
+    push(record.price);
+    push(record.size);
+    push(record.flags);
+    push(record.ts_in_delta);
+    push(record.sequence);
+    
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        push(record.bid_prices[i]);
+        push(record.bid_sizes[i]);
+        push(record.bid_counts[i]);
+        push(record.ask_prices[i]);
+        push(record.ask_sizes[i]);
+        push(record.ask_counts[i]);
+    }
+    
+    push(SymbolIndex(record.symbol));
+    push(static_cast<int64_t>(record.order_id));
+    
+    if (columns_[0].size() >= row_group_size_) {
+        WriteRowGroup();
+    }
+}
+
+void MBPColumnarWriter::Flush() {
+    // Row groups are only complete once full; partial groups are written on Close()
+    file_.flush();
+}
+
+void MBPColumnarWriter::Close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    
+    if (!columns_[0].empty()) {
+        WriteRowGroup();
+    }
+    WriteFooter();
+    file_.close();
+    if (file_.fail()) {
+        throw std::runtime_error("Failed to write columnar MBP output");
+    }
+}
+
+void MBPColumnarWriter::AppendBytes(const std::string& bytes) {
+    file_.write(bytes.data(), bytes.size());
+    file_offset_ += bytes.size();
+}
+
+void MBPColumnarWriter::WriteRowGroup() {
+    const auto& schema = Schema();
+    RowGroup group;
+    group.row_count = columns_[0].size();
+    group.columns.reserve(schema.size());
+    
+    for (size_t c = 0; c < schema.size(); ++c) {
+        auto& values = columns_[c];
+        
+        // Empty levels are nulls: keep the sentinel out of min/max so the stats can prune scans
+        bool nullable = schema[c].kind == ColumnKind::Price;
+        ColumnChunk chunk{file_offset_, 0, 0, kUndefPrice, kUndefPrice};
+        bool seen = false;
+        for (int64_t value : values) {
+            if (nullable && value == kUndefPrice) {
+                chunk.null_count++;
+            } else if (!seen) {
+                chunk.min_value = chunk.max_value = value;
+                seen = true;
+            } else {
+                chunk.min_value = std::min(chunk.min_value, value);
+                chunk.max_value = std::max(chunk.max_value, value);
+            }
+        }
+        
+        encode_buffer_.clear();
+        EncodeColumn(schema[c].encoding, values, encode_buffer_);
+        chunk.length = encode_buffer_.size();
+        group.columns.push_back(chunk);
+        AppendBytes(encode_buffer_);
+        values.clear();
+    }
+    
+    row_groups_.push_back(std::move(group));
+}
+
+void MBPColumnarWriter::WriteFooter() {
+    std::string footer;
+    uint64_t footer_offset = file_offset_;
+    
+    PutFixed<uint32_t>(static_cast<uint32_t>(Schema().size()), footer);
+    
+    PutFixed<uint32_t>(static_cast<uint32_t>(symbols_.size()), footer);
+    for (const auto& symbol : symbols_) {
+        PutFixed<uint16_t>(static_cast<uint16_t>(symbol.size()), footer);
+        footer += symbol;
+    }
+    
+    PutFixed<uint64_t>(row_groups_.size(), footer);
+    for (const auto& group : row_groups_) {
+        PutFixed<uint64_t>(group.row_count, footer);
+        for (const auto& chunk : group.columns) {
+            PutFixed(chunk.offset, footer);
+            PutFixed(chunk.length, footer);
+            PutFixed(chunk.null_count, footer);
+            PutFixed(chunk.min_value, footer);
+            PutFixed(chunk.max_value, footer);
+        }
+    }
+    
+    PutFixed<uint64_t>(footer_offset, footer);
+    footer.append(MAGIC, sizeof(MAGIC));
+    AppendBytes(footer);
+}
+
+int64_t MBPColumnarWriter::SymbolIndex(const std::string& symbol) {
+    // Instruments per file are few; a linear scan beats hashing here
+    for (size_t i = 0; i < symbols_.size(); ++i) {
+        if (symbols_[i] == symbol) {
+            return static_cast<int64_t>(i);
+        }
+    }
+    symbols_.push_back(symbol);
+    return static_cast<int64_t>(symbols_.size() - 1);
+}
+
+MBPColumnarReader::MBPColumnarReader(const std::string& filename) {
+    file_.open(filename, std::ios::binary);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Failed to open input file: " + filename);
+    }
+    
+    // Trailer: footer offset + magic
+    constexpr size_t TRAILER_SIZE = sizeof(uint64_t) + sizeof(MAGIC);
+    file_.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(file_.tellg());
+    if (file_size < 8 + TRAILER_SIZE) {
+        throw std::runtime_error("Not a columnar MBP file: " + filename);
+    }
+    
+    // Header: magic + version (the footer layout depends on the version)
+    char header[sizeof(MAGIC) + sizeof(uint16_t)];
+    file_.seekg(0);
+    file_.read(header, sizeof(header));
+    uint16_t version;
+    std::memcpy(&version, header + sizeof(MAGIC), sizeof(version));
+    if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a columnar MBP file: " + filename);
+    }
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported columnar MBP version " + std::to_string(version) + " in " + filename);
+    }
+    
+    char trailer[TRAILER_SIZE];
+    file_.seekg(file_size - TRAILER_SIZE);
+    file_.read(trailer, TRAILER_SIZE);
+    uint64_t footer_offset;
+    std::memcpy(&footer_offset, trailer, sizeof(footer_offset));
+    if (std::memcmp(trailer + sizeof(footer_offset), MAGIC, sizeof(MAGIC)) != 0 ||
+        footer_offset >= file_size - TRAILER_SIZE) {
+        throw std::runtime_error("Not a columnar MBP file: " + filename);
+    }
+    
+    std::string footer(file_size - TRAILER_SIZE - footer_offset, '\0');
+    file_.seekg(footer_offset);
+    file_.read(&footer[0], footer.size());
+    
+    const char* pos = footer.data();
+    const char* end = pos + footer.size();
+    
+    if (GetFixed<uint32_t>(pos, end) != Schema().size()) {
+        throw std::runtime_error("Unsupported columnar schema in " + filename);
+    }
+    
+    uint32_t symbol_count = GetFixed<uint32_t>(pos, end);
+    for (uint32_t i = 0; i < symbol_count; ++i) {
+        uint16_t length = GetFixed<uint16_t>(pos, end);
+        if (static_cast<size_t>(end - pos) < length) {
+            throw std::runtime_error("Truncated columnar footer");
+        }
+        symbols_.emplace_back(pos, length);
+        pos += length;
+    }
+    
+    uint64_t group_count = GetFixed<uint64_t>(pos, end);
+    for (uint64_t g = 0; g < group_count; ++g) {
+        RowGroup group;
+        group.row_count = GetFixed<uint64_t>(pos, end);
+        group.columns.resize(Schema().size());
+        for (auto& chunk : group.columns) {
+            chunk.offset = GetFixed<uint64_t>(pos, end);
+            chunk.length = GetFixed<uint64_t>(pos, end);
+            chunk.null_count = GetFixed<uint64_t>(pos, end);
+            chunk.min_value = GetFixed<int64_t>(pos, end);
+            chunk.max_value = GetFixed<int64_t>(pos, end);
+        }
+        row_count_ += group.row_count;
+        row_groups_.push_back(std::move(group));
+    }
+}
+
+size_t MBPColumnarReader::ColumnIndex(const std::string& name) {
+    const auto& schema = Schema();
+    for (size_t i = 0; i < schema.size(); ++i) {
+        if (schema[i].name == name) {
+            return i;
+        }
+    }
+    throw std::invalid_argument("Unknown column: " + name);
+}
+
+std::vector<std::vector<int64_t>> MBPColumnarReader::ReadColumns(const std::vector<std::string>& names) const {
+    std::vector<std::vector<int64_t>> result(names.size());
+    std::string chunk_data;
+    
+    for (size_t n = 0; n < names.size(); ++n) {
+        size_t column = ColumnIndex(names[n]);
+        Encoding encoding = Schema()[column].encoding;
+        result[n].reserve(row_count_);
+        
+        for (const auto& group : row_groups_) {
+            const ColumnChunk& chunk = group.columns[column];
+            chunk_data.resize(chunk.length);
+            file_.clear();
+            file_.seekg(chunk.offset);
+            if (!file_.read(&chunk_data[0], chunk.length)) {
+                throw std::runtime_error("Failed to read column " + names[n]);
+            }
+            DecodeColumn(encoding, chunk_data.data(), chunk_data.size(), group.row_count, result[n]);
+        }
+    }
+    
+    return result;
+}
@@ -0,0 +1,190 @@
+#include "mbp_delta.h"
+#include "utils.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::string_view kHeader = "index,ts_event,action,side,price,size,flags,sequence,order_id,type,levels";
+
+} // namespace
+
+MBPDeltaWriter::MBPDeltaWriter(const std::string& filename, uint32_t snapshot_interval)
+    : snapshot_interval_(snapshot_interval) {
+    file_.open(filename, std::ios::trunc);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Failed to open output file: " + filename);
+    }
+    
+    file_ << kHeader << '\n';
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+MBPDeltaWriter::~MBPDeltaWriter() {
+    try {
+        Close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error closing delta MBP output: " << e.what() << std::endl;
+    }
+}
+
+void MBPDeltaWriter::Write(uint64_t index, const MBPRecord& record, LevelMask changed) {
+    bool snapshot = !has_snapshot_ || (snapshot_interval_ > 0 && rows_since_snapshot_ >= snapshot_interval_);
+    if (snapshot) {
+        changed = kAllLevelsChanged;
+        has_snapshot_ = true;
+        rows_since_snapshot_ = 0;
+    }
+    rows_since_snapshot_++;
+    
+    buffer_ += std::to_string(index);
+    buffer_ += ',';
+    buffer_ += record.ts_event;
+    buffer_ += ',';
+    buffer_ += record.action;
+    buffer_ += ',';
+    buffer_ += record.side;
+    buffer_ += ',';
+    buffer_ += utils::FormatPrice(record.price);
+    buffer_ += ',';
+    buffer_ += std::to_string(record.size);
+    buffer_ += ',';
+    buffer_ += std::to_string(record.flags);
+    buffer_ += ',';
+    buffer_ += std::to_string(record.sequence);
+    buffer_ += ',';
+    buffer_ += std::to_string(record.order_id);
+    buffer_ += snapshot ? ",S," : ",U,";
+    
+    bool first = true;
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        if (changed & (LevelMask{1} << i)) {
+            CompactPriceLevel level = record.GetBidLevel(i);
+            CompactPriceLevel& last = levels_[i];
+            if (snapshot || level.price != last.price || level.size != last.size || level.count != last.count) {
+                last = level;
+                AppendLevel(BID_SIDE, i, level, first);
+            }
+        }
+    }
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        if (changed & (LevelMask{1} << (MBP_LEVELS + i))) {
+            CompactPriceLevel level = record.GetAskLevel(i);
+            CompactPriceLevel& last = levels_[MBP_LEVELS + i];
+            if (snapshot || level.price != last.price || level.size != last.size || level.count != last.count) {
+                last = level;
+                AppendLevel(ASK_SIDE, i, level, first);
+            }
+        }
+    }
+    buffer_ += '\n';
+    
+    if (buffer_.size() >= BUFFER_SIZE) {
+        Flush();
+    }
+}
+
+void MBPDeltaWriter::AppendLevel(char side, int level, const CompactPriceLevel& values, bool& first) {
+    if (!first) {
+        buffer_ += '|';
+    }
+    first = false;
+    
+    buffer_ += side;
+    buffer_ += ':';
+    buffer_ += std::to_string(level);
+    buffer_ += ':';
+    buffer_ += utils::FormatPrice(values.price);
+    buffer_ += ':';
+    buffer_ += std::to_string(values.size);
+    buffer_ += ':';
+    buffer_ += std::to_string(values.count);
+}
+
+void MBPDeltaWriter::Flush() {
+    if (!buffer_.empty()) {
+        file_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+}
+
+void MBPDeltaWriter::Close() {
+    if (!file_.is_open()) {
+        return;
+    }
+    
+    Flush();
+    file_.close();
+    if (file_.fail()) {
+        throw std::runtime_error("Failed to write delta MBP output");
+    }
+}
+
+MBPDeltaReader::MBPDeltaReader(const std::string& filename) : input_(filename) {
+    std::string_view header;
+    if (!input_.ReadLine(header) || header != kHeader) {
+        throw std::runtime_error("Not a delta MBP file: " + filename);
+    }
+}
+
+bool MBPDeltaReader::Next(uint64_t& index, MBPRecord& record) {
+    std::string_view line;
+    if (!input_.ReadLine(line)) {
+        return false;
+    }
+    line_number_++;
+    auto malformed = [this](const std::string& what) {
+        return std::runtime_error("Delta line " + std::to_string(line_number_) + ": " + what);
+    };
+    
+    auto fields = utils::SplitCSVLine(line);
+    if (fields.size() != 11 || fields[2].size() != 1 || fields[3].size() != 1 || fields[9].size() != 1) {
+        throw malformed("expected 11 fields");
+    }
+    index = utils::ParseUint64(fields[0]);
+    record.ts_event = std::string(fields[1]);
+    record.action = fields[2][0];
+    record.side = fields[3][0];
+    record.price = utils::ParsePrice(fields[4]);
+    record.size = utils::ParseUint32(fields[5]);
+    record.flags = utils::ParseUint8(fields[6]);
+    record.sequence = utils::ParseUint32(fields[7]);
+    record.order_id = utils::ParseUint64(fields[8]);
+    
+    if (fields[9][0] == 'S') {
+        has_snapshot_ = true;
+    } else if (fields[9][0] != 'U') {
+        throw malformed("unknown row type");
+    } else if (!has_snapshot_) {
+        throw malformed("update before the first snapshot");
+    }
+    
+    // side:level_index:price:size:count tuples separated by '|'
+    std::string_view levels = fields[10];
+    while (!levels.empty()) {
+        size_t end = levels.find('|');
+        std::string_view tuple = levels.substr(0, end);
+        levels = end == std::string_view::npos ? std::string_view() : levels.substr(end + 1);
+        
+        std::string_view parts[5];
+        for (auto& part : parts) {
+            size_t colon = tuple.find(':');
+            part = tuple.substr(0, colon);
+            tuple = colon == std::string_view::npos ? std::string_view() : tuple.substr(colon + 1);
+        }
+        uint32_t level = utils::ParseUint32(parts[1]);
+        if ((parts[0] != "B" && parts[0] != "A") || level >= MBP_LEVELS) {
+            throw malformed("bad level tuple");
+        }
+        levels_[(parts[0] == "A" ? MBP_LEVELS : 0) + level] =
+            CompactPriceLevel(utils::ParsePrice(parts[2]), utils::ParseUint32(parts[3]), utils::ParseUint32(parts[4]));
+    }
+    
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        const auto& bid = levels_[i];
+        const auto& ask = levels_[MBP_LEVELS + i];
+        record.SetBidLevel(i, bid.price, bid.size, bid.count);
+        record.SetAskLevel(i, ask.price, ask.size, ask.count);
+    }
+    return true;
+}
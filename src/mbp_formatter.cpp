@@ -0,0 +1,104 @@
+#include "mbp_formatter.h"
+#include "utils.h"
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+template <typename Integer>
+char* WriteInteger(char* pos, char* end, Integer value) {
+    return std::to_chars(pos, end, value).ptr;
+}
+
+template <typename Integer>
+void AppendInteger(std::string& out, Integer value) {
+    char buffer[24];
+    out.append(buffer, WriteInteger(buffer, buffer + sizeof(buffer), value));
+}
+
+} // namespace
+
+void MBPRowFormatter::AppendRow(uint64_t index, const MBPRecord& record, LevelMask changed, std::string& out) {
+    bool force = !primed_;
+    if (force) {
+        changed = kAllLevelsChanged;
+        primed_ = true;
+    }
+    
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        if (changed & (LevelMask{1} << i)) {
+            UpdateSlot(slots_[2 * i], record.bid_prices[i], record.bid_sizes[i], record.bid_counts[i], force);
+        }
+        if (changed & (LevelMask{1} << (MBP_LEVELS + i))) {
+            UpdateSlot(slots_[2 * i + 1], record.ask_prices[i], record.ask_sizes[i], record.ask_counts[i], force);
+        }
+    }
+    
+    // Metadata fields
+    AppendInteger(out, index);
+    out += ',';
+    out += record.ts_recv;
+    out += ',';
+    out += record.ts_event;
+    out += ',';
+    AppendInteger(out, static_cast<int>(record.rtype));
+    out += ',';
+    AppendInteger(out, record.publisher_id);
+    out += ',';
+    AppendInteger(out, record.instrument_id);
+    out += ',';
+    out += record.action;
+    out += ',';
+    out += record.side;
+    out += ',';
+    AppendInteger(out, record.depth);
+    out += ',';
+    out += utils::FormatPrice(record.price);
+    out += ',';
+    AppendInteger(out, record.size);
+    out += ',';
+    AppendInteger(out, static_cast<int>(record.flags));
+    out += ',';
+    AppendInteger(out, record.ts_in_delta);
+    out += ',';
+    AppendInteger(out, record.sequence);
+    out += ',';
+    
+    // Level slots, copied from the cache in one pass
+    size_t levels_length = 0;
+    for (const auto& slot : slots_) {
+        levels_length += slot.length;
+    }
+    size_t offset = out.size();
+    out.resize(offset + levels_length);
+    char* dest = &out[offset];
+    for (const auto& slot : slots_) {
+        std::memcpy(dest, slot.text.data(), slot.length);
+        dest += slot.length;
+    }
+    
+    // Final fields
+    out += record.symbol;
+    out += ',';
+    AppendInteger(out, record.order_id);
+    out += '\n';
+}
+
+void MBPRowFormatter::UpdateSlot(SlotText& slot, Price price, Size size, uint32_t count, bool force) {
+    if (!force && slot.level.price == price && slot.level.size == size && slot.level.count == count) {
+        return;
+    }
+    slot.level = CompactPriceLevel(price, size, count);
+    
+    char* pos = slot.text.data();
+    char* end = pos + slot.text.size();
+    std::string price_text = utils::FormatPrice(price);
+    std::memcpy(pos, price_text.data(), price_text.size());
+    pos += price_text.size();
+    *pos++ = ',';
+    pos = WriteInteger(pos, end, size);
+    *pos++ = ',';
+    pos = WriteInteger(pos, end, count);
+    *pos++ = ',';
+    slot.length = static_cast<uint8_t>(pos - slot.text.data());
+}
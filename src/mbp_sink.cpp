@@ -0,0 +1,31 @@
+#include "mbp_sink.h"
+#include "mbp_binary.h"
+#include "mbp_columnar.h"
+#include "mbp_delta.h"
+#include "gzip_stream.h"
+#include <stdexcept>
+
+OutputFormat ParseOutputFormat(const std::string& name) {
+    if (name == "csv") return OutputFormat::CSV;
+    if (name == "binary") return OutputFormat::Binary;
+    if (name == "columnar") return OutputFormat::Columnar;
+    if (name == "delta") return OutputFormat::Delta;
+    throw std::invalid_argument("Unknown output format: " + name);
+}
+
+std::unique_ptr<MBPSink> MakeMBPSink(const std::string& filename, const OutputOptions& options) {
+    if (utils::IsGzipPath(filename)) {
+        throw std::invalid_argument("gzip output is only supported for CSV: " + filename);
+    }
+    switch (options.format) {
+        case OutputFormat::Binary:
+            return std::make_unique<MBPBinaryWriter>(filename);
+        case OutputFormat::Columnar:
+            return std::make_unique<MBPColumnarWriter>(filename, options.row_group_size);
+        case OutputFormat::Delta:
+            return std::make_unique<MBPDeltaWriter>(filename, options.snapshot_interval);
+        case OutputFormat::CSV:
+            break;
+    }
+    throw std::invalid_argument("CSV output is written by MBOProcessor directly");
+}
@@ -0,0 +1,189 @@
+#include "memory_accounting.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace memory_accounting {
+
+namespace {
+
+std::string FormatBytes(uint64_t bytes) {
+    char text[32];
+    if (bytes >= 1024ULL * 1024 * 1024) {
+        std::snprintf(text, sizeof(text), "%.2f GB", bytes / (1024.0 * 1024 * 1024));
+    } else if (bytes >= 1024ULL * 1024) {
+        std::snprintf(text, sizeof(text), "%.2f MB", bytes / (1024.0 * 1024));
+    } else if (bytes >= 1024) {
+        std::snprintf(text, sizeof(text), "%.2f KB", bytes / 1024.0);
+    } else {
+        std::snprintf(text, sizeof(text), "%llu B", static_cast<unsigned long long>(bytes));
+    }
+    return text;
+}
+
+uint64_t NonNegative(int64_t bytes) {
+    return bytes > 0 ? static_cast<uint64_t>(bytes) : 0;
+}
+
+/**
+ * Live ThreadCounters, plus what exited threads left behind
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadCounters*> threads;
+    int64_t retired_current[kBookCategoryCount]{};
+    int64_t retired_peak[kBookCategoryCount]{};
+    int64_t retired_total_peak{0};
+    int64_t buffer_total_peak{0};   // Tracked total seen when buffers grew
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+} // namespace
+
+ThreadCounters::ThreadCounters() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+ThreadCounters::~ThreadCounters() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t category = 0; category < kBookCategoryCount; ++category) {
+        registry.retired_current[category] += current_[category].load(std::memory_order_relaxed);
+        registry.retired_peak[category] = std::max(registry.retired_peak[category],
+                                                   peak_[category].load(std::memory_order_relaxed));
+    }
+    registry.retired_total_peak = std::max(registry.retired_total_peak, total_peak_.load(std::memory_order_relaxed));
+    registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+}
+
+void AddBufferBytes(size_t bytes) {
+    g_buffer_counter.Add(bytes);
+    
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    int64_t total = g_buffer_counter.current.load(std::memory_order_relaxed);
+    for (int64_t retired : registry.retired_current) {
+        total += retired;
+    }
+    for (const ThreadCounters* counters : registry.threads) {
+        total += counters->total_.load(std::memory_order_relaxed);
+    }
+    registry.buffer_total_peak = std::max(registry.buffer_total_peak, total);
+}
+
+const char* CategoryName(Category category) {
+    switch (category) {
+        case Category::Levels: return "levels";
+        case Category::Orders: return "orders";
+        case Category::Lookup: return "lookup";
+        case Category::Buffers: return "buffers";
+        default: return "unknown";
+    }
+}
+
+uint64_t ReadRssBytes() {
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    unsigned long long size_pages = 0;
+    unsigned long long resident_pages = 0;
+    int fields = std::fscanf(statm, "%llu %llu", &size_pages, &resident_pages);
+    std::fclose(statm);
+    if (fields != 2) {
+        return 0;
+    }
+    return resident_pages * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+}
+
+RssSampler::RssSampler(uint64_t interval_ns) : interval_ns_(interval_ns) {
+    Sample();
+    thread_ = std::thread(&RssSampler::Run, this);
+}
+
+RssSampler::~RssSampler() {
+    Stop();
+}
+
+void RssSampler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    stop_cv_.notify_one();
+    thread_.join();
+    Sample();
+}
+
+void RssSampler::Sample() {
+    uint64_t rss = ReadRssBytes();
+    current_bytes_.store(rss, std::memory_order_relaxed);
+    if (rss > peak_bytes_.load(std::memory_order_relaxed)) {
+        peak_bytes_.store(rss, std::memory_order_relaxed);
+    }
+    samples_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RssSampler::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_cv_.wait_for(lock, std::chrono::nanoseconds(interval_ns_), [this] { return stopping_; })) {
+        lock.unlock();
+        Sample();
+        lock.lock();
+    }
+}
+
+void Report(std::ostream& out, const RssSampler* rss) {
+    int64_t current[kCategoryCount]{};
+    int64_t peak[kCategoryCount]{};
+    int64_t total_peak = 0;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (size_t category = 0; category < kBookCategoryCount; ++category) {
+            current[category] = registry.retired_current[category];
+            peak[category] = registry.retired_peak[category];
+            for (const ThreadCounters* counters : registry.threads) {
+                current[category] += counters->current_[category].load(std::memory_order_relaxed);
+                peak[category] = std::max(peak[category], counters->peak_[category].load(std::memory_order_relaxed));
+            }
+        }
+        total_peak = std::max(registry.retired_total_peak, registry.buffer_total_peak);
+        for (const ThreadCounters* counters : registry.threads) {
+            total_peak = std::max(total_peak, counters->total_peak_.load(std::memory_order_relaxed));
+        }
+    }
+    size_t buffers = static_cast<size_t>(Category::Buffers);
+    current[buffers] = g_buffer_counter.current.load(std::memory_order_relaxed);
+    peak[buffers] = g_buffer_counter.peak.load(std::memory_order_relaxed);
+    
+    uint64_t total_current = 0;
+    out << "Memory (current / peak):\n";
+    for (size_t category = 0; category < kCategoryCount; ++category) {
+        total_current += NonNegative(current[category]);
+        out << "  " << std::left << std::setw(9) << CategoryName(static_cast<Category>(category)) << std::right
+            << std::setw(12) << FormatBytes(NonNegative(current[category])) << " / "
+            << FormatBytes(NonNegative(peak[category])) << "\n";
+    }
+    out << "  " << std::left << std::setw(9) << "tracked" << std::right << std::setw(12) << FormatBytes(total_current)
+        << " / " << FormatBytes(std::max(NonNegative(total_peak), total_current)) << "\n";
+    if (rss != nullptr && rss->SampleCount() > 0) {
+        out << "  " << std::left << std::setw(9) << "rss" << std::right << std::setw(12) << FormatBytes(rss->CurrentBytes())
+            << " / " << FormatBytes(rss->PeakBytes()) << " (" << rss->SampleCount() << " samples)\n";
+    }
+}
+
+} // namespace memory_accounting
@@ -3,6 +3,45 @@
 #include <stdexcept>
 #include <iostream>
 
+namespace {
+
+/**
+ * Number of levels ahead of the given price, capped at MBP_LEVELS
+ */
+template <typename Levels>
+size_t VisibleRank(const Levels& levels, Price price) {
+    size_t rank = 0;
+    auto better = levels.key_comp();
+    for (auto it = levels.begin(); it != levels.end() && rank < MBP_LEVELS && better(it->first, price); ++it) {
+        ++rank;
+    }
+    return rank;
+}
+
+/**
+ * Check that every level is non-empty, keyed by its own price and that its
+ * count and total match its orders
+ */
+template <typename Levels>
+bool ValidateLevelTotals(const Levels& levels, const char* side_name) {
+    for (const auto& [price, level] : levels) {
+        uint64_t total = 0;
+        for (const auto& [order_id, size] : level.orders) {
+            total += size;
+        }
+        if (level.IsEmpty() || level.price != price || level.order_count != level.orders.size() ||
+            level.total_size != total) {
+            std::cerr << side_name << " level " << price << " inconsistent: price " << level.price << ", count "
+                      << level.order_count << " for " << level.orders.size() << " orders, total "
+                      << level.total_size << " for " << total << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 void OrderBook::Apply(const MBORecord& record) {
     if (!record.IsValid()) {
         throw std::invalid_argument("Invalid MBO record");
@@ -39,11 +78,13 @@ void OrderBook::AddOrder(const MBORecord& record) {
     
     // Add order to the appropriate price level
     PriceLevel& level = GetOrCreateLevel(record.side, record.price);
+    bool new_level = level.order_count == 0;
     level.AddOrder(record.order_id, record.size);
     
     // Track the order location
     order_lookup_[record.order_id] = OrderLocation(record.price, record.side);
     
+    MarkLevelChanged(record.side, record.price, new_level);
     MarkChanged();
 }
 
@@ -60,6 +101,7 @@ void OrderBook::CancelOrder(const MBORecord& record) {
     // Remove from price level
     PriceLevel& level = GetOrCreateLevel(side, price);
     level.RemoveOrder(record.order_id);
+    bool level_removed = level.IsEmpty();
     
     // Remove from order lookup
     order_lookup_.erase(it);
@@ -67,6 +109,7 @@ void OrderBook::CancelOrder(const MBORecord& record) {
     // Remove empty price level
     RemoveEmptyLevel(side, price);
     
+    MarkLevelChanged(side, price, level_removed);
     MarkChanged();
 }
 
@@ -78,6 +121,11 @@ void OrderBook::ModifyOrder(const MBORecord& record) {
         return;
     }
     
+    // Reject a side the book cannot hold before the order leaves its old level
+    if (record.side != BID_SIDE && record.side != ASK_SIDE) {
+        throw std::invalid_argument("Invalid side: " + std::string(1, record.side));
+    }
+    
     Price old_price = it->second.price;
     char old_side = it->second.side;
     
@@ -86,11 +134,15 @@ void OrderBook::ModifyOrder(const MBORecord& record) {
         // Remove from old level
         PriceLevel& old_level = GetOrCreateLevel(old_side, old_price);
         old_level.RemoveOrder(record.order_id);
+        bool old_level_removed = old_level.IsEmpty();
         RemoveEmptyLevel(old_side, old_price);
+        MarkLevelChanged(old_side, old_price, old_level_removed);
         
         // Add to new level
         PriceLevel& new_level = GetOrCreateLevel(record.side, record.price);
+        bool level_created = new_level.order_count == 0;
         new_level.AddOrder(record.order_id, record.size);
+        MarkLevelChanged(record.side, record.price, level_created);
         
         // Update order lookup
         it->second = OrderLocation(record.price, record.side);
@@ -98,6 +150,7 @@ void OrderBook::ModifyOrder(const MBORecord& record) {
         // Same price and side, just modify size
         PriceLevel& level = GetOrCreateLevel(record.side, record.price);
         level.ModifyOrder(record.order_id, record.size);
+        MarkLevelChanged(record.side, record.price, false);
     }
     
     MarkChanged();
@@ -107,9 +160,22 @@ void OrderBook::Clear() {
     bids_.clear();
     asks_.clear();
     order_lookup_.clear();
+    changed_levels_ = kAllLevelsChanged;
     MarkChanged();
 }
 
+void OrderBook::MarkLevelChanged(char side, Price price, bool shifted) {
+    size_t rank = (side == BID_SIDE) ? VisibleRank(bids_, price) : VisibleRank(asks_, price);
+    if (rank >= MBP_LEVELS) {
+        return;  // Below the visible depth, nothing in the top N moved
+    }
+    
+    // A created or removed level shifts every deeper visible level by one slot
+    LevelMask side_mask = shifted ? (kSideLevelsMask & ~((LevelMask{1} << rank) - 1))
+                                  : (LevelMask{1} << rank);
+    changed_levels_ |= (side == ASK_SIDE) ? (side_mask << MBP_LEVELS) : side_mask;
+}
+
 std::vector<CompactPriceLevel> OrderBook::GetTopBids(size_t levels) const {
     bid_levels_cache_.clear();
     
@@ -268,5 +334,5 @@ bool OrderBook::ValidateConsistency() const {
         }
     }
     
-    return true;
+    return ValidateLevelTotals(bids_, "Bid") && ValidateLevelTotals(asks_, "Ask");
 } 
\ No newline at end of file
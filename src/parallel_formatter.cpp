@@ -0,0 +1,225 @@
+#include "parallel_formatter.h"
+#include "stage_timer.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+void MBPSnapshot::Assign(uint64_t row_index, const MBPRecord& record) {
+    index = row_index;
+    price = record.price;
+    order_id = record.order_id;
+    publisher_id = record.publisher_id;
+    instrument_id = record.instrument_id;
+    depth = record.depth;
+    size = record.size;
+    ts_in_delta = record.ts_in_delta;
+    sequence = record.sequence;
+    rtype = record.rtype;
+    flags = record.flags;
+    action = record.action;
+    side = record.side;
+    ts_recv.Assign(record.ts_recv);
+    ts_event.Assign(record.ts_event);
+    symbol.Assign(record.symbol);
+    
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        bids[i] = record.GetBidLevel(i);
+        asks[i] = record.GetAskLevel(i);
+    }
+}
+
+void MBPSnapshot::CopyTo(MBPRecord& record) const {
+    record.price = price;
+    record.order_id = order_id;
+    record.publisher_id = static_cast<uint16_t>(publisher_id);
+    record.instrument_id = instrument_id;
+    record.depth = depth;
+    record.size = size;
+    record.ts_in_delta = ts_in_delta;
+    record.sequence = sequence;
+    record.rtype = rtype;
+    record.flags = flags;
+    record.action = action;
+    record.side = side;
+    ts_recv.CopyTo(record.ts_recv);
+    ts_event.CopyTo(record.ts_event);
+    symbol.CopyTo(record.symbol);
+    
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        record.SetBidLevel(i, bids[i].price, bids[i].size, bids[i].count);
+        record.SetAskLevel(i, asks[i].price, asks[i].size, asks[i].count);
+    }
+}
+
+ParallelRowFormatter::ParallelRowFormatter(size_t thread_count, size_t batch_size, ChunkWriter writer)
+    : batch_size_(std::max<size_t>(batch_size, 1)), writer_(std::move(writer)) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    
+    // Enough batches for every worker plus one being filled and one being written
+    size_t batch_count = 2 * thread_count + 2;
+    for (size_t i = 0; i < batch_count; ++i) {
+        batches_.push_back(std::make_unique<Batch>());
+        batches_.back()->rows.reserve(batch_size_);
+        free_.push_back(batches_.back().get());
+    }
+    
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&ParallelRowFormatter::RunWorker, this);
+    }
+    sequencer_ = std::thread(&ParallelRowFormatter::RunSequencer, this);
+}
+
+ParallelRowFormatter::~ParallelRowFormatter() {
+    try {
+        Finish();
+    } catch (const std::exception& e) {
+        std::cerr << "Error finishing parallel formatter: " << e.what() << std::endl;
+    }
+}
+
+void ParallelRowFormatter::Push(uint64_t index, const MBPRecord& record) {
+    if (current_ == nullptr) {
+        current_ = AcquireBatch();
+    }
+    
+    current_->rows.emplace_back();
+    current_->rows.back().Assign(index, record);
+    
+    if (current_->rows.size() >= batch_size_) {
+        SubmitCurrent();
+    }
+}
+
+void ParallelRowFormatter::Flush() {
+    if (current_ != nullptr && !current_->rows.empty()) {
+        SubmitCurrent();
+    }
+}
+
+void ParallelRowFormatter::Finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    
+    // Queue the partial batch unless a worker already failed
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_ && current_ != nullptr && !current_->rows.empty()) {
+            current_->sequence = next_sequence_++;
+            queued_.push_back(current_);
+            current_ = nullptr;
+        }
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    done_cv_.notify_all();
+    
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    sequencer_.join();
+    RethrowError();
+}
+
+ParallelRowFormatter::Batch* ParallelRowFormatter::AcquireBatch() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    free_cv_.wait(lock, [this] { return !free_.empty() || error_; });
+    RethrowError();
+    
+    Batch* batch = free_.back();
+    free_.pop_back();
+    return batch;
+}
+
+void ParallelRowFormatter::SubmitCurrent() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        RethrowError();
+        current_->sequence = next_sequence_++;
+        queued_.push_back(current_);
+        current_ = nullptr;
+    }
+    work_cv_.notify_one();
+}
+
+void ParallelRowFormatter::RunWorker() {
+    STAGE_THREAD_NAME("formatter");
+    MBPRowFormatter formatter;
+    MBPRecord scratch;
+    
+    while (true) {
+        Batch* batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this] { return !queued_.empty() || stopping_; });
+            if (queued_.empty()) {
+                return;
+            }
+            batch = queued_.front();
+            queued_.pop_front();
+        }
+        
+        // Rows within a batch are consecutive, so level text carries over between them
+        formatter.Invalidate();
+        for (const auto& row : batch->rows) {
+            STAGE_TIMER(Format);
+            row.CopyTo(scratch);
+            formatter.AppendRow(row.index, scratch, kAllLevelsChanged, batch->text);
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            formatted_[batch->sequence] = batch;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+void ParallelRowFormatter::RunSequencer() {
+    STAGE_THREAD_NAME("sequencer");
+    bool failed = false;
+    
+    while (true) {
+        Batch* batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_cv_.wait(lock, [this] {
+                return formatted_.count(next_to_write_) != 0 || (stopping_ && next_to_write_ == next_sequence_);
+            });
+            auto it = formatted_.find(next_to_write_);
+            if (it == formatted_.end()) {
+                return;  // Stopping and everything has been written
+            }
+            batch = it->second;
+            formatted_.erase(it);
+        }
+        
+        // After a write error, keep draining so the book thread never blocks on the pool
+        try {
+            if (!failed) {
+                writer_(batch->text);
+            }
+        } catch (...) {
+            failed = true;
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = std::current_exception();
+        }
+        batch->rows.clear();
+        batch->text.clear();
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            next_to_write_++;
+            free_.push_back(batch);
+        }
+        free_cv_.notify_one();
+        done_cv_.notify_all();
+    }
+}
+
+void ParallelRowFormatter::RethrowError() {
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
@@ -0,0 +1,236 @@
+#include "persistent_book.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+using persistent_book::LevelChunk;
+using persistent_book::SideLevels;
+
+namespace {
+
+/**
+ * True if price a sorts ahead of price b on the given side
+ */
+inline bool Better(char side, Price a, Price b) {
+    return side == BID_SIDE ? a > b : a < b;
+}
+
+/**
+ * True if only this handle refers to the object
+ *
+ * Only the writer thread creates new references (Snapshot()), so a count of
+ * one cannot go back up behind our back; the fence orders our writes after
+ * the last reader's accesses that preceded its release.
+ */
+template <typename T>
+bool IsUnique(const std::shared_ptr<T>& ptr) {
+    if (ptr.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+void CheckSide(char side) {
+    if (side != BID_SIDE && side != ASK_SIDE) {
+        throw std::invalid_argument("Invalid side: " + std::string(1, side));
+    }
+}
+
+} // namespace
+
+const SideLevels* OrderBookSnapshot::Side(char side) const {
+    return side == BID_SIDE ? bids_.get() : side == ASK_SIDE ? asks_.get() : nullptr;
+}
+
+size_t OrderBookSnapshot::LevelCount(char side) const {
+    const SideLevels* levels = Side(side);
+    return levels != nullptr ? levels->level_count : 0;
+}
+
+std::vector<CompactPriceLevel> OrderBookSnapshot::GetTopLevels(char side, size_t levels) const {
+    std::vector<CompactPriceLevel> top;
+    const SideLevels* side_levels = Side(side);
+    if (side_levels == nullptr) {
+        return top;
+    }
+    
+    top.reserve(std::min(levels, side_levels->level_count));
+    for (const auto& chunk : side_levels->chunks) {
+        for (const CompactPriceLevel& level : chunk->levels) {
+            if (top.size() >= levels) {
+                return top;
+            }
+            top.push_back(level);
+        }
+    }
+    return top;
+}
+
+PersistentOrderBook::PersistentOrderBook()
+    : bids_(std::make_shared<SideLevels>()), asks_(std::make_shared<SideLevels>()) {
+    order_lookup_.reserve(INITIAL_ORDER_CAPACITY);
+}
+
+void PersistentOrderBook::Apply(const MBORecord& record) {
+    if (!record.IsValid()) {
+        throw std::invalid_argument("Invalid MBO record");
+    }
+    
+    switch (record.action) {
+        case ACTION_ADD:
+            AddOrder(record);
+            break;
+        case ACTION_CANCEL:
+            CancelOrder(record);
+            break;
+        case ACTION_MODIFY:
+            ModifyOrder(record);
+            break;
+        case ACTION_CLEAR:
+            Clear();
+            break;
+        case ACTION_TRADE:
+        case ACTION_FILL:
+        case ACTION_NONE:
+            // These actions don't affect the order book
+            break;
+        default:
+            throw std::invalid_argument("Unknown action: " + std::string(1, record.action));
+    }
+    ++version_;
+}
+
+void PersistentOrderBook::AddOrder(const MBORecord& record) {
+    CheckSide(record.side);
+    auto [it, inserted] = order_lookup_.try_emplace(record.order_id, OrderEntry{record.price, record.size, record.side});
+    if (!inserted) {
+        throw std::runtime_error("Order ID " + std::to_string(record.order_id) + " already exists");
+    }
+    AdjustLevel(record.side, record.price, record.size, 1);
+}
+
+void PersistentOrderBook::CancelOrder(const MBORecord& record) {
+    auto it = order_lookup_.find(record.order_id);
+    if (it == order_lookup_.end()) {
+        return;  // Same as OrderBook: unknown orders are ignored
+    }
+    
+    OrderEntry entry = it->second;
+    order_lookup_.erase(it);
+    AdjustLevel(entry.side, entry.price, -static_cast<int64_t>(entry.size), -1);
+}
+
+void PersistentOrderBook::ModifyOrder(const MBORecord& record) {
+    auto it = order_lookup_.find(record.order_id);
+    if (it == order_lookup_.end()) {
+        AddOrder(record);
+        return;
+    }
+    
+    OrderEntry& entry = it->second;
+    if (entry.price != record.price || entry.side != record.side) {
+        CheckSide(record.side);
+        AdjustLevel(entry.side, entry.price, -static_cast<int64_t>(entry.size), -1);
+        AdjustLevel(record.side, record.price, record.size, 1);
+    } else {
+        AdjustLevel(entry.side, entry.price, static_cast<int64_t>(record.size) - static_cast<int64_t>(entry.size), 0);
+    }
+    entry = OrderEntry{record.price, record.size, record.side};
+}
+
+void PersistentOrderBook::Clear() {
+    // Fresh sides; snapshots keep the old ones alive
+    bids_ = std::make_shared<SideLevels>();
+    asks_ = std::make_shared<SideLevels>();
+    order_lookup_.clear();
+}
+
+OrderBookSnapshot PersistentOrderBook::Snapshot() const {
+    OrderBookSnapshot snapshot;
+    snapshot.bids_ = bids_;
+    snapshot.asks_ = asks_;
+    snapshot.version_ = version_;
+    snapshot.order_count_ = order_lookup_.size();
+    return snapshot;
+}
+
+SideLevels& PersistentOrderBook::MutableSide(char side) {
+    SidePtr& levels = side == BID_SIDE ? bids_ : asks_;
+    if (!IsUnique(levels)) {
+        // Copies chunk pointers only; the chunks themselves stay shared
+        levels = std::make_shared<SideLevels>(*levels);
+    }
+    return *levels;
+}
+
+LevelChunk& PersistentOrderBook::MutableChunk(SideLevels& levels, size_t index) {
+    auto& chunk = levels.chunks[index];
+    if (!IsUnique(chunk)) {
+        chunk = std::make_shared<LevelChunk>(*chunk);
+        ++chunks_copied_;
+    }
+    return *chunk;
+}
+
+void PersistentOrderBook::AdjustLevel(char side, Price price, int64_t size_delta, int32_t count_delta) {
+    SideLevels& levels = MutableSide(side);
+    auto& chunks = levels.chunks;
+    
+    // First chunk whose worst level does not sort ahead of the price
+    auto chunk_it = std::partition_point(chunks.begin(), chunks.end(), [&](const std::shared_ptr<LevelChunk>& chunk) {
+        return Better(side, chunk->levels.back().price, price);
+    });
+    
+    if (chunk_it == chunks.end()) {
+        if (count_delta <= 0) {
+            return;  // Level not present; nothing to take away
+        }
+        if (chunks.empty() || chunks.back()->levels.size() >= persistent_book::kChunkLevels) {
+            chunks.push_back(std::make_shared<LevelChunk>());
+            chunks.back()->levels.reserve(persistent_book::kChunkLevels);
+        }
+        chunk_it = chunks.end() - 1;
+    }
+    
+    size_t chunk_index = static_cast<size_t>(chunk_it - chunks.begin());
+    const auto& shared_levels = chunks[chunk_index]->levels;
+    auto level_it = std::partition_point(shared_levels.begin(), shared_levels.end(), [&](const CompactPriceLevel& level) {
+        return Better(side, level.price, price);
+    });
+    size_t level_index = static_cast<size_t>(level_it - shared_levels.begin());
+    bool found = level_it != shared_levels.end() && level_it->price == price;
+    
+    if (!found && count_delta <= 0) {
+        return;
+    }
+    
+    LevelChunk& chunk = MutableChunk(levels, chunk_index);
+    if (!found) {
+        chunk.levels.insert(chunk.levels.begin() + level_index,
+                            CompactPriceLevel(price, static_cast<Size>(size_delta), static_cast<uint32_t>(count_delta)));
+        ++levels.level_count;
+        
+        if (chunk.levels.size() > persistent_book::kChunkLevels) {
+            // Split the overfull chunk in half
+            auto upper = std::make_shared<LevelChunk>();
+            upper->levels.reserve(persistent_book::kChunkLevels);
+            upper->levels.assign(chunk.levels.begin() + chunk.levels.size() / 2, chunk.levels.end());
+            chunk.levels.resize(chunk.levels.size() / 2);
+            chunks.insert(chunks.begin() + chunk_index + 1, std::move(upper));
+        }
+        return;
+    }
+    
+    CompactPriceLevel& level = chunk.levels[level_index];
+    level.size = static_cast<Size>(static_cast<int64_t>(level.size) + size_delta);
+    level.count = static_cast<uint32_t>(static_cast<int64_t>(level.count) + count_delta);
+    if (level.count == 0) {
+        chunk.levels.erase(chunk.levels.begin() + level_index);
+        --levels.level_count;
+        if (chunk.levels.empty()) {
+            chunks.erase(chunks.begin() + chunk_index);
+        }
+    }
+}
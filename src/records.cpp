@@ -2,7 +2,7 @@
 #include "utils.h"
 #include <stdexcept>
 
-MBORecord MBORecord::Parse(const std::string& line) {
+MBORecord MBORecord::Parse(std::string_view line) {
     auto fields = utils::SplitCSVLine(line);
     
     if (fields.size() != 15) {
@@ -0,0 +1,118 @@
+#include "reference_book.h"
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void RequireBookSide(char side) {
+    if (side != BID_SIDE && side != ASK_SIDE) {
+        throw std::invalid_argument("Invalid side: " + std::string(1, side));
+    }
+}
+
+/**
+ * Aggregate consecutive orders of equal price into levels, stopping after `levels` prices
+ */
+template <typename Iterator>
+std::vector<ReferenceBook::Level> Aggregate(Iterator begin, Iterator end, size_t levels) {
+    std::vector<ReferenceBook::Level> result;
+    for (auto it = begin; it != end; ++it) {
+        Price price = it->first.first;
+        if (result.empty() || result.back().price != price) {
+            if (result.size() == levels) {
+                break;
+            }
+            result.push_back(ReferenceBook::Level{price, 0, 0});
+        }
+        result.back().size += it->second;
+        result.back().count++;
+    }
+    return result;
+}
+
+template <typename Iterator>
+size_t CountPrices(Iterator begin, Iterator end) {
+    size_t count = 0;
+    Price last = kUndefPrice;
+    for (auto it = begin; it != end; ++it) {
+        if (count == 0 || it->first.first != last) {
+            last = it->first.first;
+            count++;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+void ReferenceBook::Apply(const MBORecord& record) {
+    if (!record.IsValid()) {
+        throw std::invalid_argument("Invalid MBO record");
+    }
+    
+    switch (record.action) {
+        case ACTION_ADD:
+            if (orders_.count(record.order_id) != 0) {
+                throw std::runtime_error("Order ID " + std::to_string(record.order_id) + " already exists");
+            }
+            RequireBookSide(record.side);
+            Insert(record.order_id, RestingOrder{record.side, record.price, record.size});
+            break;
+        case ACTION_CANCEL: {
+            // Cancels remove the whole order whatever their size; unknown IDs are ignored
+            auto it = orders_.find(record.order_id);
+            if (it != orders_.end()) {
+                Erase(it);
+            }
+            break;
+        }
+        case ACTION_MODIFY: {
+            // Unknown IDs are treated as adds; known ones take the new side, price and size
+            RequireBookSide(record.side);
+            auto it = orders_.find(record.order_id);
+            if (it != orders_.end()) {
+                Erase(it);
+            }
+            Insert(record.order_id, RestingOrder{record.side, record.price, record.size});
+            break;
+        }
+        case ACTION_CLEAR:
+            Clear();
+            break;
+        default:
+            // Trades, fills and none leave the book unchanged
+            break;
+    }
+}
+
+void ReferenceBook::Clear() {
+    orders_.clear();
+    bids_.clear();
+    asks_.clear();
+}
+
+void ReferenceBook::Insert(OrderID order_id, const RestingOrder& order) {
+    orders_.emplace(order_id, order);
+    auto& side = (order.side == BID_SIDE) ? bids_ : asks_;
+    side.emplace(std::make_pair(order.price, order_id), order.size);
+}
+
+void ReferenceBook::Erase(std::map<OrderID, RestingOrder>::iterator it) {
+    auto& side = (it->second.side == BID_SIDE) ? bids_ : asks_;
+    side.erase(std::make_pair(it->second.price, it->first));
+    orders_.erase(it);
+}
+
+std::vector<ReferenceBook::Level> ReferenceBook::TopLevels(char side, size_t levels) const {
+    if (side == BID_SIDE) {
+        return Aggregate(bids_.rbegin(), bids_.rend(), levels);
+    }
+    return Aggregate(asks_.begin(), asks_.end(), levels);
+}
+
+size_t ReferenceBook::LevelCount(char side) const {
+    if (side == BID_SIDE) {
+        return CountPrices(bids_.begin(), bids_.end());
+    }
+    return CountPrices(asks_.begin(), asks_.end());
+}
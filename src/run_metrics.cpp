@@ -0,0 +1,182 @@
+#include "run_metrics.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+
+bool IsPrometheusPath(const std::string& path) {
+    const std::string suffix = ".prom";
+    return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * Escape a string for a JSON value or a Prometheus label (same rules for the characters we emit)
+ */
+std::string Escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c == '\n' ? ' ' : c;
+    }
+    return escaped;
+}
+
+void PrometheusMetric(std::ostream& out, const char* name, const char* type, const char* help, double value) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+    out << name << " " << value << "\n";
+}
+
+} // namespace
+
+void WriteMetricsJson(std::ostream& out, const RunMetrics& metrics) {
+    double ns_per_tick = metrics.stages.empty() ? 0.0 : utils::CycleClock::NanosPerTick();
+    
+    out << std::setprecision(12);
+    out << "{\n";
+    out << "  \"complete\": " << (metrics.complete ? "true" : "false") << ",\n";
+    out << "  \"elapsed_seconds\": " << metrics.elapsed_seconds << ",\n";
+    out << "  \"records_processed\": " << metrics.records_processed << ",\n";
+    out << "  \"records_rejected\": " << metrics.records_rejected << ",\n";
+    out << "  \"records_per_second\": "
+        << (metrics.elapsed_seconds > 0 ? metrics.records_processed / metrics.elapsed_seconds : 0.0) << ",\n";
+    out << "  \"rows_written\": " << metrics.rows_written << ",\n";
+    out << "  \"rows_suppressed\": " << metrics.rows_suppressed << ",\n";
+    out << "  \"bytes_in\": " << metrics.bytes_in << ",\n";
+    out << "  \"bytes_out\": " << metrics.bytes_out << ",\n";
+    out << "  \"book\": {\"bid_levels\": " << metrics.bid_levels << ", \"ask_levels\": " << metrics.ask_levels
+        << ", \"resting_orders\": " << metrics.resting_orders << "},\n";
+    out << "  \"rss_bytes\": " << metrics.rss_bytes << ",\n";
+    out << "  \"latency_ns\": {\"p50\": " << metrics.latency_p50_ns << ", \"p99\": " << metrics.latency_p99_ns
+        << ", \"max\": " << metrics.latency_max_ns << "},\n";
+    out << "  \"stages\": [";
+    bool first = true;
+    for (const auto& thread : metrics.stages) {
+        for (size_t stage = 0; stage < stage_timer::kStageCount; ++stage) {
+            if (thread.calls[stage] == 0) {
+                continue;
+            }
+            out << (first ? "\n" : ",\n") << "    {\"thread\": \"" << Escape(thread.name) << "\", \"stage\": \""
+                << stage_timer::StageName(static_cast<stage_timer::Stage>(stage)) << "\", \"calls\": "
+                << thread.calls[stage] << ", \"seconds\": " << thread.ticks[stage] * ns_per_tick / 1e9 << "}";
+            first = false;
+        }
+    }
+    out << (first ? "]" : "\n  ]") << ",\n";
+    out << "  \"metrics_write_errors\": " << metrics.metrics_write_errors << "\n";
+    out << "}\n";
+}
+
+void WriteMetricsPrometheus(std::ostream& out, const RunMetrics& metrics) {
+    out << std::setprecision(12);
+    PrometheusMetric(out, "mbo2mbp_run_complete", "gauge", "1 once the run has finished", metrics.complete ? 1 : 0);
+    PrometheusMetric(out, "mbo2mbp_elapsed_seconds", "gauge", "Time since processing started", metrics.elapsed_seconds);
+    PrometheusMetric(out, "mbo2mbp_records_processed_total", "counter", "MBO records applied to the book",
+                     static_cast<double>(metrics.records_processed));
+    PrometheusMetric(out, "mbo2mbp_records_rejected_total", "counter", "Input records that failed to parse or apply",
+                     static_cast<double>(metrics.records_rejected));
+    PrometheusMetric(out, "mbo2mbp_rows_written_total", "counter", "MBP rows emitted",
+                     static_cast<double>(metrics.rows_written));
+    PrometheusMetric(out, "mbo2mbp_rows_suppressed_total", "counter", "MBP rows suppressed as invisible changes",
+                     static_cast<double>(metrics.rows_suppressed));
+    PrometheusMetric(out, "mbo2mbp_input_bytes_total", "counter", "Bytes read from the input",
+                     static_cast<double>(metrics.bytes_in));
+    PrometheusMetric(out, "mbo2mbp_output_bytes_total", "counter", "Bytes of MBP output produced",
+                     static_cast<double>(metrics.bytes_out));
+    PrometheusMetric(out, "mbo2mbp_resting_orders", "gauge", "Orders resting in the book",
+                     static_cast<double>(metrics.resting_orders));
+    PrometheusMetric(out, "mbo2mbp_rss_bytes", "gauge", "Resident set size", static_cast<double>(metrics.rss_bytes));
+    PrometheusMetric(out, "mbo2mbp_metrics_write_errors_total", "counter", "Periodic metrics writes that failed",
+                     static_cast<double>(metrics.metrics_write_errors));
+    
+    out << "# HELP mbo2mbp_book_levels Price levels in the book\n";
+    out << "# TYPE mbo2mbp_book_levels gauge\n";
+    out << "mbo2mbp_book_levels{side=\"bid\"} " << metrics.bid_levels << "\n";
+    out << "mbo2mbp_book_levels{side=\"ask\"} " << metrics.ask_levels << "\n";
+    
+    out << "# HELP mbo2mbp_record_latency_seconds Per-record latency from parse to row written\n";
+    out << "# TYPE mbo2mbp_record_latency_seconds gauge\n";
+    out << "mbo2mbp_record_latency_seconds{quantile=\"0.5\"} " << metrics.latency_p50_ns / 1e9 << "\n";
+    out << "mbo2mbp_record_latency_seconds{quantile=\"0.99\"} " << metrics.latency_p99_ns / 1e9 << "\n";
+    out << "mbo2mbp_record_latency_seconds{quantile=\"1\"} " << metrics.latency_max_ns / 1e9 << "\n";
+    
+    if (metrics.stages.empty()) {
+        return;
+    }
+    double ns_per_tick = utils::CycleClock::NanosPerTick();
+    out << "# HELP mbo2mbp_stage_seconds_total Time spent per pipeline stage\n";
+    out << "# TYPE mbo2mbp_stage_seconds_total counter\n";
+    for (const auto& thread : metrics.stages) {
+        for (size_t stage = 0; stage < stage_timer::kStageCount; ++stage) {
+            if (thread.calls[stage] > 0) {
+                out << "mbo2mbp_stage_seconds_total{thread=\"" << Escape(thread.name) << "\",stage=\""
+                    << stage_timer::StageName(static_cast<stage_timer::Stage>(stage)) << "\"} "
+                    << thread.ticks[stage] * ns_per_tick / 1e9 << "\n";
+            }
+        }
+    }
+    out << "# HELP mbo2mbp_stage_calls_total Timed calls per pipeline stage\n";
+    out << "# TYPE mbo2mbp_stage_calls_total counter\n";
+    for (const auto& thread : metrics.stages) {
+        for (size_t stage = 0; stage < stage_timer::kStageCount; ++stage) {
+            if (thread.calls[stage] > 0) {
+                out << "mbo2mbp_stage_calls_total{thread=\"" << Escape(thread.name) << "\",stage=\""
+                    << stage_timer::StageName(static_cast<stage_timer::Stage>(stage)) << "\"} " << thread.calls[stage]
+                    << "\n";
+            }
+        }
+    }
+}
+
+MetricsExporter::MetricsExporter(std::vector<std::string> paths, uint64_t interval_ns)
+    : paths_(std::move(paths)), interval_ns_(interval_ns), next_write_ns_(utils::MonotonicNanos() + interval_ns) {
+}
+
+bool MetricsExporter::Due() const {
+    return utils::MonotonicNanos() >= next_write_ns_;
+}
+
+void MetricsExporter::Write(const RunMetrics& metrics) {
+    for (const auto& path : paths_) {
+        // Same directory as the destination, so the rename cannot cross filesystems
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary);
+            if (!out.is_open()) {
+                throw std::runtime_error("Failed to open metrics file: " + temporary);
+            }
+            if (IsPrometheusPath(path)) {
+                WriteMetricsPrometheus(out, metrics);
+            } else {
+                WriteMetricsJson(out, metrics);
+            }
+            out.flush();
+            if (!out) {
+                throw std::runtime_error("Failed to write metrics file: " + temporary);
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Failed to move metrics file into place: " + path);
+        }
+    }
+    writes_++;
+    next_write_ns_ = utils::MonotonicNanos() + interval_ns_;
+}
+
+bool MetricsExporter::TryWrite(const RunMetrics& metrics) {
+    try {
+        Write(metrics);
+        return true;
+    } catch (const std::exception& e) {
+        if (failures_++ == 0) {
+            std::cerr << "Warning: " << e.what() << " (metrics export continues; later failures are only counted)"
+                      << std::endl;
+        }
+        next_write_ns_ = utils::MonotonicNanos() + interval_ns_;
+        return false;
+    }
+}
@@ -0,0 +1,208 @@
+#include "shm_book.h"
+#include "utils.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shm_book {
+
+std::string SegmentName(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+} // namespace shm_book
+
+ShmBookPublisher::ShmBookPublisher(const std::string& name, uint32_t capacity)
+    : name_(shm_book::SegmentName(name)) {
+    if (capacity == 0) {
+        throw std::invalid_argument("Shared-memory book capacity must be positive");
+    }
+    
+    // Start from a fresh segment so readers never see a stale layout
+    ::shm_unlink(name_.c_str());
+    int fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create shared memory " + name_ + ": " + std::strerror(errno));
+    }
+    
+    region_size_ = sizeof(shm_book::Header) + capacity * sizeof(shm_book::Slot);
+    if (::ftruncate(fd, static_cast<off_t>(region_size_)) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to size shared memory " + name_ + ": " + std::strerror(errno));
+    }
+    region_ = ::mmap(nullptr, region_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (region_ == MAP_FAILED) {
+        region_ = nullptr;
+        throw std::runtime_error("Failed to map shared memory " + name_ + ": " + std::strerror(errno));
+    }
+    
+    // ftruncate zero-fills, so every slot starts with an even (idle) sequence
+    header_ = static_cast<shm_book::Header*>(region_);
+    slots_ = reinterpret_cast<shm_book::Slot*>(header_ + 1);
+    header_->version = shm_book::VERSION;
+    header_->capacity = capacity;
+    header_->slot_size = sizeof(shm_book::Slot);
+    header_->instrument_count.store(0, std::memory_order_relaxed);
+    
+    // Readers check the magic last, once the rest of the header is in place
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, shm_book::MAGIC, sizeof(shm_book::MAGIC));
+}
+
+ShmBookPublisher::~ShmBookPublisher() {
+    if (region_) {
+        ::munmap(region_, region_size_);
+    }
+}
+
+shm_book::Slot* ShmBookPublisher::SlotFor(uint32_t instrument_id) {
+    if (last_slot_ && instrument_id == last_instrument_) {
+        return last_slot_;
+    }
+    
+    auto it = slot_by_instrument_.find(instrument_id);
+    shm_book::Slot* slot;
+    if (it != slot_by_instrument_.end()) {
+        slot = it->second;
+    } else {
+        uint32_t index = header_->instrument_count.load(std::memory_order_relaxed);
+        if (index >= header_->capacity) {
+            throw std::runtime_error("Shared-memory book is full (" + std::to_string(header_->capacity) + " instruments)");
+        }
+        slot = &slots_[index];
+        slot->instrument_id = instrument_id;
+        header_->instrument_count.store(index + 1, std::memory_order_release);
+        slot_by_instrument_.emplace(instrument_id, slot);
+    }
+    
+    last_slot_ = slot;
+    last_instrument_ = instrument_id;
+    return slot;
+}
+
+void ShmBookPublisher::Publish(const MBPRecord& record) {
+    // Everything that can be computed outside the write section is
+    uint64_t ts_event = ts_event_parser_.Parse(record.ts_event);
+    uint64_t ts_recv = ts_recv_parser_.Parse(record.ts_recv);
+    shm_book::Slot* slot = SlotFor(record.instrument_id);
+    
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    shm_book::BookSnapshot& book = slot->book;
+    book.instrument_id = record.instrument_id;
+    book.publisher_id = record.publisher_id;
+    book.update_count = sequence / 2 + 1;
+    book.ts_event = ts_event;
+    book.ts_recv = ts_recv;
+    book.price = record.price;
+    book.size = record.size;
+    book.sequence = record.sequence;
+    book.action = record.action;
+    book.side = record.side;
+    book.flags = record.flags;
+    book.depth = static_cast<uint8_t>(record.depth);
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        book.bids[i] = CompactPriceLevel(record.bid_prices[i], record.bid_sizes[i], record.bid_counts[i]);
+        book.asks[i] = CompactPriceLevel(record.ask_prices[i], record.ask_sizes[i], record.ask_counts[i]);
+    }
+    
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+ShmBookReader::ShmBookReader(const std::string& name) {
+    std::string segment = shm_book::SegmentName(name);
+    int fd = ::shm_open(segment.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open shared memory " + segment + ": " + std::strerror(errno));
+    }
+    
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(shm_book::Header)) {
+        ::close(fd);
+        throw std::runtime_error("Shared memory " + segment + " is not a book region");
+    }
+    region_size_ = static_cast<size_t>(info.st_size);
+    region_ = ::mmap(nullptr, region_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (region_ == MAP_FAILED) {
+        region_ = nullptr;
+        throw std::runtime_error("Failed to map shared memory " + segment + ": " + std::strerror(errno));
+    }
+    
+    header_ = static_cast<const shm_book::Header*>(region_);
+    slots_ = reinterpret_cast<const shm_book::Slot*>(header_ + 1);
+    if (std::memcmp(header_->magic, shm_book::MAGIC, sizeof(shm_book::MAGIC)) != 0 ||
+        header_->version != shm_book::VERSION || header_->slot_size != sizeof(shm_book::Slot) ||
+        region_size_ < sizeof(shm_book::Header) + header_->capacity * sizeof(shm_book::Slot)) {
+        ::munmap(const_cast<void*>(region_), region_size_);
+        region_ = nullptr;
+        throw std::runtime_error("Shared memory " + segment + " has an incompatible layout");
+    }
+}
+
+ShmBookReader::~ShmBookReader() {
+    if (region_) {
+        ::munmap(const_cast<void*>(region_), region_size_);
+    }
+}
+
+std::vector<uint32_t> ShmBookReader::Instruments() const {
+    uint32_t count = header_->instrument_count.load(std::memory_order_acquire);
+    std::vector<uint32_t> instruments;
+    instruments.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        instruments.push_back(slots_[i].instrument_id);
+    }
+    return instruments;
+}
+
+const shm_book::Slot* ShmBookReader::FindSlot(uint32_t instrument_id) const {
+    auto it = slot_by_instrument_.find(instrument_id);
+    if (it != slot_by_instrument_.end()) {
+        return it->second;
+    }
+    
+    // Slots are only ever appended, so a found slot can be cached for good
+    uint32_t count = header_->instrument_count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (slots_[i].instrument_id == instrument_id) {
+            slot_by_instrument_.emplace(instrument_id, &slots_[i]);
+            return &slots_[i];
+        }
+    }
+    return nullptr;
+}
+
+bool ShmBookReader::Read(uint32_t instrument_id, shm_book::BookSnapshot& out) const {
+    const shm_book::Slot* slot = FindSlot(instrument_id);
+    if (!slot) {
+        return false;
+    }
+    
+    for (uint32_t attempt = 0; attempt < shm_book::READ_RETRY_LIMIT; ++attempt) {
+        uint64_t before = slot->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            utils::CpuRelax();   // Writer is mid-update
+            continue;
+        }
+        std::memcpy(&out, &slot->book, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) == before) {
+            return before != 0;
+        }
+    }
+    throw std::runtime_error("Book of instrument " + std::to_string(instrument_id) +
+                             " is stuck mid-update; its writer may have died");
+}
+
+uint64_t ShmBookReader::UpdateCount(uint32_t instrument_id) const {
+    const shm_book::Slot* slot = FindSlot(instrument_id);
+    return slot ? slot->sequence.load(std::memory_order_acquire) / 2 : 0;
+}
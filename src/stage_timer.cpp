@@ -0,0 +1,199 @@
+#include "stage_timer.h"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace stage_timer {
+
+namespace {
+
+/**
+ * Every thread's table; tables outlive their threads so the report sees them
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadTotals>> threads;
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+bool HasHwCounts(const ThreadTotals& totals) {
+    for (size_t event = 0; event < kHwEventCount; ++event) {
+        if (totals.hw_open[event]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t ThreadTicks(const ThreadTotals& totals) {
+    uint64_t ticks = 0;
+    for (size_t stage = 0; stage < kStageCount; ++stage) {
+        ticks += totals.ticks[stage];
+    }
+    return ticks;
+}
+
+} // namespace
+
+const char* StageName(Stage stage) {
+    switch (stage) {
+        case Stage::Parse: return "parse";
+        case Stage::Apply: return "apply";
+        case Stage::Snapshot: return "snapshot";
+        case Stage::Format: return "format";
+        case Stage::Write: return "write";
+        default: return "unknown";
+    }
+}
+
+ThreadTotals& LocalTotals() {
+    thread_local ThreadTotals* totals = [] {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.push_back(std::make_unique<ThreadTotals>());
+        ThreadTotals* created = registry.threads.back().get();
+        created->name = "thread-" + std::to_string(registry.threads.size());
+        return created;
+    }();
+    return *totals;
+}
+
+std::vector<ThreadTotals> CollectTotals() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<ThreadTotals> totals;
+    for (const auto& thread : registry.threads) {
+        for (size_t stage = 0; stage < kStageCount; ++stage) {
+            if (thread->calls[stage] > 0) {
+                totals.push_back(*thread);
+                break;
+            }
+        }
+    }
+    return totals;
+}
+
+void SetThreadName(const char* name) {
+    LocalTotals().name = name;
+}
+
+void AttachHwCounters(const HwCounters* counters) {
+    ThreadTotals& totals = LocalTotals();
+    totals.hw_counters = counters;
+    if (counters == nullptr) {
+        return;   // Keep hw_open so the counts gathered so far are still reported
+    }
+    for (size_t event = 0; event < kHwEventCount; ++event) {
+        totals.hw_open[event] = counters->IsOpen(static_cast<HwEvent>(event));
+    }
+}
+
+void Report(std::ostream& out) {
+    if (!kEnabled) {
+        return;
+    }
+    
+    std::vector<ThreadTotals> totals = CollectTotals();
+    double ns_per_tick = utils::CycleClock::NanosPerTick();
+    
+    out << "Stage breakdown (cycle counter, " << std::fixed << std::setprecision(3) << ns_per_tick << " ns/tick)\n";
+    out << "  " << std::left << std::setw(12) << "thread" << std::setw(10) << "stage" << std::right
+        << std::setw(12) << "calls" << std::setw(12) << "total ms" << std::setw(10) << "ns/call" << std::setw(9) << "share" << "\n";
+    for (const auto& thread : totals) {
+        uint64_t thread_ticks = ThreadTicks(thread);
+        for (size_t stage = 0; stage < kStageCount; ++stage) {
+            if (thread.calls[stage] == 0) {
+                continue;
+            }
+            double total_ns = thread.ticks[stage] * ns_per_tick;
+            out << "  " << std::left << std::setw(12) << thread.name << std::setw(10) << StageName(static_cast<Stage>(stage))
+                << std::right << std::setw(12) << thread.calls[stage] << std::setprecision(2) << std::setw(12) << total_ns / 1e6
+                << std::setprecision(0) << std::setw(10) << total_ns / thread.calls[stage] << std::setprecision(1)
+                << std::setw(8) << (thread_ticks > 0 ? 100.0 * thread.ticks[stage] / thread_ticks : 0.0) << "%\n";
+        }
+    }
+    
+    // Counter deltas per call, for threads that had a counter group attached
+    for (const auto& thread : totals) {
+        if (!HasHwCounts(thread)) {
+            continue;
+        }
+        out << "Stage counters per call (" << thread.name << ")\n  " << std::left << std::setw(10) << "stage" << std::right;
+        for (size_t event = 0; event < kHwEventCount; ++event) {
+            if (thread.hw_open[event]) {
+                out << std::setw(15) << HwEventName(static_cast<HwEvent>(event));
+            }
+        }
+        out << "\n";
+        for (size_t stage = 0; stage < kStageCount; ++stage) {
+            if (thread.calls[stage] == 0) {
+                continue;
+            }
+            out << "  " << std::left << std::setw(10) << StageName(static_cast<Stage>(stage)) << std::right << std::setprecision(1);
+            for (size_t event = 0; event < kHwEventCount; ++event) {
+                if (thread.hw_open[event]) {
+                    out << std::setw(15) << static_cast<double>(thread.hw[stage].values[event]) / thread.calls[stage];
+                }
+            }
+            out << "\n";
+        }
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+void WriteJson(const std::string& filename) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open stage report file: " + filename);
+    }
+    
+    std::vector<ThreadTotals> totals = CollectTotals();
+    double ns_per_tick = kEnabled ? utils::CycleClock::NanosPerTick() : 0.0;
+    
+    out << "{\n  \"enabled\": " << (kEnabled ? "true" : "false") << ",\n";
+    out << "  \"ns_per_tick\": " << std::setprecision(6) << ns_per_tick << ",\n";
+    out << "  \"threads\": [";
+    for (size_t i = 0; i < totals.size(); ++i) {
+        const ThreadTotals& thread = totals[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << thread.name << "\", \"stages\": {";
+        bool first = true;
+        for (size_t stage = 0; stage < kStageCount; ++stage) {
+            if (thread.calls[stage] == 0) {
+                continue;
+            }
+            uint64_t total_ns = static_cast<uint64_t>(thread.ticks[stage] * ns_per_tick);
+            out << (first ? "" : ", ") << "\"" << StageName(static_cast<Stage>(stage)) << "\": {\"calls\": "
+                << thread.calls[stage] << ", \"total_ns\": " << total_ns << ", \"ns_per_call\": "
+                << total_ns / thread.calls[stage];
+            if (HasHwCounts(thread)) {
+                out << ", \"counters\": {";
+                bool first_event = true;
+                for (size_t event = 0; event < kHwEventCount; ++event) {
+                    if (thread.hw_open[event]) {
+                        out << (first_event ? "" : ", ") << "\"" << HwEventName(static_cast<HwEvent>(event))
+                            << "\": " << thread.hw[stage].values[event];
+                        first_event = false;
+                    }
+                }
+                out << "}";
+            }
+            out << "}";
+            first = false;
+        }
+        out << "}}";
+    }
+    out << (totals.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    
+    if (!out) {
+        throw std::runtime_error("Failed to write stage report file: " + filename);
+    }
+}
+
+} // namespace stage_timer
@@ -1,7 +1,11 @@
 #include "utils.h"
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
 #include <cctype>
 #include <cmath>
+#include <stdexcept>
 
 namespace utils {
 
@@ -84,18 +88,140 @@ std::string FormatPrice(Price price) {
     return oss.str();
 }
 
+namespace {
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm)
+int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void CivilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2);
+}
+
+void WriteDigits(char* dest, uint64_t value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        dest[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// Fractional seconds of an ISO 8601 timestamp, right-padded to nanoseconds
+uint64_t ParseFractionNanos(std::string_view timestamp_str) {
+    uint64_t nanos = 0;
+    int digits = 0;
+    if (timestamp_str.size() > 19 && timestamp_str[19] == '.') {
+        for (size_t i = 20; i < timestamp_str.size() && digits < 9; ++i) {
+            char c = timestamp_str[i];
+            if (c < '0' || c > '9') break;
+            nanos = nanos * 10 + (c - '0');
+            ++digits;
+        }
+    }
+    for (; digits < 9; ++digits) {
+        nanos *= 10;
+    }
+    return nanos;
+}
+
+} // namespace
+
 Timestamp ParseTimestamp(std::string_view timestamp_str) {
-    // For this assignment, we'll store the timestamp as a string hash
-    // This allows us to preserve the original format when needed
-    std::hash<std::string_view> hasher;
-    return static_cast<Timestamp>(hasher(timestamp_str));
+    // Expected layout: YYYY-MM-DDTHH:MM:SS[.fffffffff]Z
+    if (timestamp_str.size() < 19 || timestamp_str[4] != '-' || timestamp_str[10] != 'T') {
+        return 0;
+    }
+    
+    int64_t year = static_cast<int64_t>(ParseUint64(timestamp_str.substr(0, 4)));
+    unsigned month = ParseUint32(timestamp_str.substr(5, 2));
+    unsigned day = ParseUint32(timestamp_str.substr(8, 2));
+    uint64_t hours = ParseUint64(timestamp_str.substr(11, 2));
+    uint64_t minutes = ParseUint64(timestamp_str.substr(14, 2));
+    uint64_t seconds = ParseUint64(timestamp_str.substr(17, 2));
+    uint64_t nanos = ParseFractionNanos(timestamp_str);
+    
+    int64_t days = DaysFromCivil(year, month, day);
+    uint64_t total_seconds = static_cast<uint64_t>(days) * 86400 + hours * 3600 + minutes * 60 + seconds;
+    return total_seconds * 1000000000ULL + nanos;
+}
+
+Timestamp TimestampParser::Parse(std::string_view timestamp_str) {
+    constexpr size_t kPrefix = sizeof(prefix_);
+    if (timestamp_str.size() < 19) {
+        return ParseTimestamp(timestamp_str);
+    }
+    
+    if (!has_prefix_ || std::memcmp(prefix_, timestamp_str.data(), kPrefix) != 0) {
+        Timestamp full = ParseTimestamp(timestamp_str);
+        if (full == 0) {
+            return 0;
+        }
+        uint64_t seconds = (timestamp_str[17] - '0') * 10 + (timestamp_str[18] - '0');
+        std::memcpy(prefix_, timestamp_str.data(), kPrefix);
+        minute_start_ = full - full % 1000000000ULL - seconds * 1000000000ULL;
+        has_prefix_ = true;
+        return full;
+    }
+    
+    uint64_t seconds = (timestamp_str[17] - '0') * 10 + (timestamp_str[18] - '0');
+    return minute_start_ + seconds * 1000000000ULL + ParseFractionNanos(timestamp_str);
 }
 
 std::string FormatTimestamp(Timestamp timestamp) {
-    // For this assignment, we need to return the original ISO timestamp format
-    // Since we're hashing the original string, we can't recover it perfectly
-    // We'll use a placeholder that matches the expected format
-    return "2025-07-17T07:05:09.035627674Z";
+    // Nanosecond-precision ISO 8601 in UTC, matching the input layout
+    uint64_t nanos = timestamp % 1000000000ULL;
+    uint64_t total_seconds = timestamp / 1000000000ULL;
+    int64_t days = static_cast<int64_t>(total_seconds / 86400);
+    uint64_t second_of_day = total_seconds % 86400;
+    
+    int64_t year;
+    unsigned month, day;
+    CivilFromDays(days, year, month, day);
+    
+    std::string result = "0000-00-00T00:00:00.000000000Z";
+    WriteDigits(&result[0], static_cast<uint64_t>(year), 4);
+    WriteDigits(&result[5], month, 2);
+    WriteDigits(&result[8], day, 2);
+    WriteDigits(&result[11], second_of_day / 3600, 2);
+    WriteDigits(&result[14], (second_of_day / 60) % 60, 2);
+    WriteDigits(&result[17], second_of_day % 60, 2);
+    WriteDigits(&result[20], nanos, 9);
+    return result;
+}
+
+uint64_t ParseDuration(std::string_view duration_str) {
+    size_t digits = 0;
+    while (digits < duration_str.size() && duration_str[digits] >= '0' && duration_str[digits] <= '9') {
+        ++digits;
+    }
+    
+    std::string_view unit = duration_str.substr(digits);
+    uint64_t multiplier = 0;
+    if (unit == "ns") multiplier = 1;
+    else if (unit == "us") multiplier = 1000;
+    else if (unit == "ms") multiplier = 1000000;
+    else if (unit == "s") multiplier = 1000000000ULL;
+    else if (unit == "m") multiplier = 60 * 1000000000ULL;
+    else if (unit == "h") multiplier = 3600 * 1000000000ULL;
+    
+    uint64_t value = ParseUint64(duration_str.substr(0, digits));
+    if (digits == 0 || multiplier == 0 || value == 0) {
+        throw std::invalid_argument("Invalid duration: " + std::string(duration_str));
+    }
+    return value * multiplier;
 }
 
 bool IsValidPrice(Price price) {
@@ -117,10 +243,119 @@ bool IsValidAction(char action) {
            action == ACTION_NONE;
 }
 
+void WriteFully(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Failed to write output: ") + std::strerror(errno));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
 void EnableFastIO() {
     std::ios_base::sync_with_stdio(false);
     std::cin.tie(nullptr);
     std::cout.tie(nullptr);
 }
 
+namespace {
+
+// Reference point for CycleClock calibration, taken during static initialization
+struct TickReference {
+    uint64_t ticks;
+    uint64_t nanos;
+};
+const TickReference kProgramStart{CycleClock::Now(), MonotonicNanos()};
+
+} // namespace
+
+double CycleClock::NanosPerTick() {
+    static const double nanos_per_tick = [] {
+        constexpr uint64_t kMinCalibrationNs = 10 * 1000000ULL;
+        uint64_t nanos;
+        uint64_t ticks;
+        do {
+            nanos = MonotonicNanos();
+            ticks = Now();
+        } while (nanos - kProgramStart.nanos < kMinCalibrationNs);
+        return ticks > kProgramStart.ticks
+            ? static_cast<double>(nanos - kProgramStart.nanos) / static_cast<double>(ticks - kProgramStart.ticks)
+            : 1.0;
+    }();
+    return nanos_per_tick;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = (index >> SUB_BUCKET_BITS) - 1;
+    uint64_t mantissa = static_cast<uint64_t>(index & (SUB_BUCKETS - 1)) + SUB_BUCKETS;
+    return ((mantissa + 1) << shift) - 1;   // Wraps to UINT64_MAX for the last bucket
+}
+
+uint64_t LatencyHistogram::Percentile(double quantile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * count_)));
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += counts_[bucket];
+        if (seen >= target) {
+            return std::min(BucketUpperBound(bucket), max_);
+        }
+    }
+    return max_;
+}
+
+void LatencyHistogram::Report(std::ostream& out, const std::string& title, double ns_per_unit) const {
+    out << title << " (" << count_ << " samples)\n";
+    if (count_ == 0) {
+        return;
+    }
+    
+    auto ns = [ns_per_unit](double value) { return static_cast<uint64_t>(value * ns_per_unit + 0.5); };
+    out << "  min " << ns(min_) << "ns  mean " << ns(static_cast<double>(sum_) / count_) << "ns  max " << ns(max_) << "ns\n";
+    out << "  p50 " << ns(Percentile(0.50)) << "ns  p90 " << ns(Percentile(0.90)) << "ns  p99 " << ns(Percentile(0.99))
+        << "ns  p99.9 " << ns(Percentile(0.999)) << "ns  max " << ns(max_) << "ns\n";
+    
+    // Coarse view: one line per power of two that holds samples
+    uint64_t octave_count = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        octave_count += counts_[bucket];
+        bool octave_end = ((bucket + 1) & (SUB_BUCKETS - 1)) == 0;
+        if (!octave_end || octave_count == 0) {
+            continue;
+        }
+        out << "  <= " << std::setw(12) << ns(BucketUpperBound(bucket)) << "ns " << std::setw(10) << octave_count << "\n";
+        octave_count = 0;
+    }
+}
+
+void PerformanceMonitor::ReportLatency(std::ostream& out) const {
+    if (record_latency_.Count() > 0) {
+        record_latency_.Report(out, "Per-record latency (parse to MBP row written)", CycleClock::NanosPerTick());
+    }
+}
+
+void PerformanceMonitor::Report() const {
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time_);
+    
+    std::cout << "=== Performance Report ===\n";
+    std::cout << "Records processed: " << records_processed_ << "\n";
+    std::cout << "MBP records generated: " << mbp_records_generated_ << "\n";
+    std::cout << "Processing time: " << duration.count() / 1000000 << "ms\n";
+    if (duration.count() > 0) {
+        std::cout << "Processing rate: " << (records_processed_ * 1e9 / duration.count()) << " records/sec\n";
+    }
+    std::cout << "Peak memory usage: " << peak_memory_usage_ << " bytes\n";
+    ReportLatency(std::cout);
+    std::cout << "========================\n";
+}
+
 } // namespace utils 
\ No newline at end of file
@@ -0,0 +1,198 @@
+#!/bin/bash
+
+# Regression tests for the output formats and row modes. Expected rows for the
+# row modes are checked in under test/expected/ and were produced from the first
+# 200 records of data/mbo.csv; regenerate them with --update after an intended
+# output change.
+
+set -u
+
+echo "=========================================="
+echo "MBO to MBP Converter - Regression Tests"
+echo "=========================================="
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+BUILDDIR=${BUILDDIR:-build}
+CONVERTER="./${BUILDDIR}/reconstruction_vanshika"
+READER="./${BUILDDIR}/mbp_reader"
+VALIDATOR="./${BUILDDIR}/mbp_validate"
+OUTDIR=test/output/regression
+EXPECTED=test/expected
+UPDATE=0
+if [ "${1:-}" == "--update" ]; then
+    UPDATE=1
+fi
+
+# Test counters
+TOTAL_TESTS=0
+PASSED_TESTS=0
+FAILED_TESTS=0
+
+pass() {
+    echo -e "  ${GREEN}✓ PASSED${NC} - $1"
+    PASSED_TESTS=$((PASSED_TESTS + 1))
+}
+
+fail() {
+    echo -e "  ${RED}✗ FAILED${NC} - $1"
+    FAILED_TESTS=$((FAILED_TESTS + 1))
+}
+
+begin_test() {
+    TOTAL_TESTS=$((TOTAL_TESTS + 1))
+    echo -e "\n${BLUE}Running Test: $1${NC}"
+    echo "Description: $2"
+}
+
+# Function to compare two files byte for byte
+check_same() {
+    local actual="$1"
+    local expected="$2"
+    local what="$3"
+
+    if cmp -s "$actual" "$expected"; then
+        pass "$what"
+    else
+        fail "$what ($actual differs from $expected)"
+        diff "$actual" "$expected" | head -5
+    fi
+}
+
+# Function to convert, exiting the test on a converter error
+convert() {
+    if ! "$CONVERTER" "$@" > "$OUTDIR/converter.log" 2>&1; then
+        tail -3 "$OUTDIR/converter.log"
+        return 1
+    fi
+}
+
+for binary in "$CONVERTER" "$READER" "$VALIDATOR"; do
+    if [ ! -x "$binary" ]; then
+        echo -e "${RED}✗ $binary not found, run make first${NC}"
+        exit 1
+    fi
+done
+
+rm -rf "$OUTDIR"
+mkdir -p "$OUTDIR"
+INPUT=data/mbo.csv
+HEAD_INPUT="$OUTDIR/mbo_head.csv"
+head -n 201 "$INPUT" > "$HEAD_INPUT"
+
+echo -e "\n${BLUE}Building reference output...${NC}"
+if ! convert "$INPUT" "$OUTDIR/reference.csv"; then
+    echo -e "${RED}✗ Reference conversion failed${NC}"
+    exit 1
+fi
+
+# Round trips through mbp_reader
+begin_test "columnar_roundtrip" "Columnar output read back by mbp_reader matches the CSV"
+if convert --format columnar "$INPUT" "$OUTDIR/out.mbpc" &&
+   "$READER" "$OUTDIR/out.mbpc" > "$OUTDIR/columnar.csv"; then
+    check_same "$OUTDIR/columnar.csv" "$OUTDIR/reference.csv" "columnar dump equals CSV output"
+else
+    fail "columnar conversion or dump failed"
+fi
+
+begin_test "binary_roundtrip" "Binary output read back by mbp_reader matches the CSV except order_id"
+if convert --format binary "$INPUT" "$OUTDIR/out.mbp" &&
+   "$READER" "$OUTDIR/out.mbp" > "$OUTDIR/binary.csv"; then
+    if "$VALIDATOR" "$OUTDIR/binary.csv" "$OUTDIR/reference.csv" --ignore order_id > "$OUTDIR/validate.log" 2>&1; then
+        pass "binary dump equals CSV output"
+    else
+        fail "binary dump differs from CSV output"
+        head -5 "$OUTDIR/validate.log"
+    fi
+else
+    fail "binary conversion or dump failed"
+fi
+
+begin_test "delta_roundtrip" "Delta output replayed by mbp_reader matches the CSV columns it keeps"
+if convert --format delta --snapshot-interval 500 "$INPUT" "$OUTDIR/out.delta" &&
+   "$READER" "$OUTDIR/out.delta" > "$OUTDIR/delta.csv"; then
+    cut -d, -f1,3,7,8,10,11,12,14,15-74,76 "$OUTDIR/reference.csv" > "$OUTDIR/reference_delta.csv"
+    check_same "$OUTDIR/delta.csv" "$OUTDIR/reference_delta.csv" "delta replay equals CSV output"
+else
+    fail "delta conversion or replay failed"
+fi
+
+# Row modes against checked-in expected rows
+check_mode() {
+    local test_name="$1"
+    local description="$2"
+    shift 2
+
+    begin_test "$test_name" "$description"
+    if ! convert "$@" "$HEAD_INPUT" "$OUTDIR/${test_name}.csv"; then
+        fail "conversion failed"
+        return
+    fi
+    if [ "$UPDATE" -eq 1 ]; then
+        cp "$OUTDIR/${test_name}.csv" "$EXPECTED/${test_name}.csv"
+        echo -e "  ${YELLOW}⚠ UPDATED${NC} - $EXPECTED/${test_name}.csv"
+        PASSED_TESTS=$((PASSED_TESTS + 1))
+        return
+    fi
+    check_same "$OUTDIR/${test_name}.csv" "$EXPECTED/${test_name}.csv" "rows match $EXPECTED/${test_name}.csv"
+}
+
+check_mode "conflate" "--conflate emits one row per F_LAST event" --conflate
+check_mode "sample_1ms" "--sample-interval 1ms emits one row per ts_event bucket" --sample-interval 1ms
+check_mode "visible_changes" "--visible-changes-only skips rows with no top-10 change" --visible-changes-only
+
+# Compressed and piped I/O
+begin_test "gzip_io" "gzip input and output convert to the same rows as plain CSV"
+gzip -c "$INPUT" > "$OUTDIR/mbo.csv.gz"
+if convert "$OUTDIR/mbo.csv.gz" "$OUTDIR/gzip.csv" && convert "$INPUT" "$OUTDIR/gzip_out.csv.gz"; then
+    check_same "$OUTDIR/gzip.csv" "$OUTDIR/reference.csv" "gzip input"
+    TOTAL_TESTS=$((TOTAL_TESTS + 1))
+    if gzip -dc "$OUTDIR/gzip_out.csv.gz" > "$OUTDIR/gzip_out.csv" 2>/dev/null; then
+        check_same "$OUTDIR/gzip_out.csv" "$OUTDIR/reference.csv" "gzip output"
+    else
+        fail "gzip output is not a valid gzip stream"
+    fi
+else
+    fail "gzip conversion failed"
+fi
+
+begin_test "stdio" "- reads stdin and writes stdout with the same rows as files"
+if "$CONVERTER" - - < "$INPUT" > "$OUTDIR/stdio.csv" 2> "$OUTDIR/converter.log"; then
+    check_same "$OUTDIR/stdio.csv" "$OUTDIR/reference.csv" "stdin to stdout"
+else
+    fail "conversion through stdin and stdout failed"
+fi
+
+# Parallel formatting keeps every row, whatever the symbol length
+begin_test "long_symbols" "--format-threads 2 matches inline formatting for 20 and 47 character symbols"
+for symbol in "ESZ5 C05800000ABCDEF" "ESZ5 C05800000ABCDEF ESZ5 C05800000ABCDEF XYZ01"; do
+    sed "s/,ARL\$/,${symbol}/" "$HEAD_INPUT" > "$OUTDIR/long_symbol.csv"
+    if convert "$OUTDIR/long_symbol.csv" "$OUTDIR/long_inline.csv" &&
+       convert --format-threads 2 "$OUTDIR/long_symbol.csv" "$OUTDIR/long_parallel.csv"; then
+        check_same "$OUTDIR/long_parallel.csv" "$OUTDIR/long_inline.csv" "${#symbol} character symbol"
+    else
+        fail "conversion with a ${#symbol} character symbol failed"
+    fi
+done
+TOTAL_TESTS=$((TOTAL_TESTS + 1))
+
+# Test summary
+echo -e "\n=========================================="
+echo -e "${BLUE}Test Summary${NC}"
+echo -e "=========================================="
+echo -e "Total Tests: ${TOTAL_TESTS}"
+echo -e "${GREEN}Passed: ${PASSED_TESTS}${NC}"
+echo -e "${RED}Failed: ${FAILED_TESTS}${NC}"
+
+if [ "$FAILED_TESTS" -eq 0 ]; then
+    echo -e "\n${GREEN}🎉 All tests passed!${NC}"
+    exit 0
+else
+    echo -e "\n${RED}❌ Some tests failed!${NC}"
+    exit 1
+fi
@@ -0,0 +1,145 @@
+#include "line_reader.h"
+#include "orderbook.h"
+#include "persistent_book.h"
+#include "records.h"
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void PrintUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <mbo_file> [--loop N] [--snapshot-every N] [--retain N]\n";
+    std::cout << "\n";
+    std::cout << "Description:\n";
+    std::cout << "  Measures writer cost of PersistentOrderBook against the mutable OrderBook.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --loop N            Replay the file N times (default: 20)\n";
+    std::cout << "  --snapshot-every N  Take a snapshot every N records (default: 1)\n";
+    std::cout << "  --retain N          Keep the last N snapshots alive, as slow readers would (default: 1)\n";
+}
+
+std::vector<MBORecord> LoadRecords(const std::string& filename) {
+    std::vector<MBORecord> records;
+    LineReader input(filename);
+    std::string_view line;
+    if (!input.ReadLine(line)) {
+        throw std::runtime_error("Input file is empty: " + filename);
+    }
+    while (input.ReadLine(line)) {
+        records.push_back(MBORecord::Parse(line));
+    }
+    return records;
+}
+
+/**
+ * Replay every record `loops` times, clearing the book between passes
+ * @return Mean nanoseconds per applied record
+ */
+template <typename Book, typename AfterApply>
+double TimeReplay(Book& book, const std::vector<MBORecord>& records, uint64_t loops, AfterApply&& after_apply) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (uint64_t loop = 0; loop < loops; ++loop) {
+        book.Clear();
+        for (const auto& record : records) {
+            book.Apply(record);
+            after_apply(book);
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time);
+    return static_cast<double>(elapsed.count()) / static_cast<double>(loops * records.size());
+}
+
+bool SameLevels(const std::vector<CompactPriceLevel>& a, const std::vector<CompactPriceLevel>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].price != b[i].price || a[i].size != b[i].size || a[i].count != b[i].count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 2) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        
+        std::string input_file = argv[1];
+        uint64_t loops = 20;
+        uint64_t snapshot_every = 1;
+        size_t retain = 1;
+        
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--loop" && i + 1 < argc) {
+                loops = std::stoull(argv[++i]);
+            } else if (arg == "--snapshot-every" && i + 1 < argc) {
+                snapshot_every = std::stoull(argv[++i]);
+            } else if (arg == "--retain" && i + 1 < argc) {
+                retain = std::stoull(argv[++i]);
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        if (loops == 0 || snapshot_every == 0) {
+            throw std::invalid_argument("--loop and --snapshot-every must be positive");
+        }
+        
+        std::vector<MBORecord> records = LoadRecords(input_file);
+        if (records.empty()) {
+            throw std::runtime_error("No records in " + input_file);
+        }
+        
+        OrderBook mutable_book;
+        double mutable_ns = TimeReplay(mutable_book, records, loops, [](OrderBook&) {});
+        
+        PersistentOrderBook plain_book;
+        double plain_ns = TimeReplay(plain_book, records, loops, [](PersistentOrderBook&) {});
+        
+        PersistentOrderBook book;
+        std::deque<OrderBookSnapshot> retained;
+        uint64_t applied = 0;
+        double snapshot_ns = TimeReplay(book, records, loops, [&](PersistentOrderBook& b) {
+            if (++applied % snapshot_every != 0) {
+                return;
+            }
+            retained.push_back(b.Snapshot());
+            if (retained.size() > retain) {
+                retained.pop_front();
+            }
+        });
+        
+        // The persistent book must agree with the mutable one it replaces
+        OrderBookSnapshot final_book = book.Snapshot();
+        bool agree = SameLevels(final_book.GetTopLevels(BID_SIDE, MBP_LEVELS), mutable_book.GetTopBids()) &&
+                     SameLevels(final_book.GetTopLevels(ASK_SIDE, MBP_LEVELS), mutable_book.GetTopAsks()) &&
+                     final_book.OrderCount() == mutable_book.GetStatistics().total_orders;
+        
+        std::cout << "Records: " << records.size() << " x " << loops << " passes\n";
+        std::cout << "  OrderBook (mutable)            " << mutable_ns << " ns/record\n";
+        std::cout << "  PersistentOrderBook            " << plain_ns << " ns/record ("
+                  << (plain_ns / mutable_ns - 1.0) * 100.0 << "% vs mutable)\n";
+        std::cout << "  PersistentOrderBook + Snapshot " << snapshot_ns << " ns/record ("
+                  << (snapshot_ns / mutable_ns - 1.0) * 100.0 << "% vs mutable), every " << snapshot_every
+                  << " records, " << retain << " retained\n";
+        std::cout << "  Chunks copied: " << book.ChunksCopied() << " ("
+                  << static_cast<double>(book.ChunksCopied()) / static_cast<double>(loops * records.size())
+                  << " per record)\n";
+        std::cout << "  Final book levels: " << final_book.LevelCount(BID_SIDE) << " bid, "
+                  << final_book.LevelCount(ASK_SIDE) << " ask; top-of-book "
+                  << (agree ? "matches" : "DIFFERS FROM") << " OrderBook\n";
+        return agree ? 0 : 1;
+    
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
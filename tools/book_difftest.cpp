@@ -0,0 +1,483 @@
+#include "line_reader.h"
+#include "mbo_generator.h"
+#include "orderbook.h"
+#include "persistent_book.h"
+#include "records.h"
+#include "reference_book.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void PrintUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]\n";
+    std::cout << "\n";
+    std::cout << "Description:\n";
+    std::cout << "  Differential test of OrderBook and PersistentOrderBook against a deliberately\n";
+    std::cout << "  simple reference book. After every record the top " << MBP_LEVELS << " levels, order counts, thrown\n";
+    std::cout << "  exceptions and changed-level masks must agree; OrderBook::ValidateConsistency\n";
+    std::cout << "  runs periodically, as does a check that a held persistent snapshot is unchanged.\n";
+    std::cout << "  A failing stream is cut at the first divergence and minimized to a short\n";
+    std::cout << "  reproducing record sequence.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --input FILE          Replay an MBO CSV file (repeatable)\n";
+    std::cout << "  --seeds N             Generated streams to replay (default: 6, or 0 with --input)\n";
+    std::cout << "  --first-seed N        Seed of the first generated stream (default: 1)\n";
+    std::cout << "  --records N           Records per generated stream (default: 100000)\n";
+    std::cout << "  --mutate P            Per record chance of injecting a hostile record into\n";
+    std::cout << "                        generated streams (default: 0.01)\n";
+    std::cout << "  --validate-every N    Records between consistency checks (default: 1000)\n";
+    std::cout << "  --max-tests N         Replay budget for minimizing a failure (default: 5000)\n";
+    std::cout << "  --out FILE            Write the minimized reproduction as MBO CSV\n";
+    std::cout << "\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << program_name << " --input data/mbo.csv --seeds 20 --out data/output/difftest_repro.csv\n";
+}
+
+struct DiffConfig {
+    std::vector<std::string> inputs;
+    uint64_t seeds{6};
+    uint64_t first_seed{1};
+    uint64_t records{100000};
+    double mutate{0.01};
+    uint64_t validate_every{1000};
+    uint64_t max_tests{5000};
+    std::string out_file;
+};
+
+/**
+ * First disagreement between OrderBook and the reference
+ */
+struct Divergence {
+    size_t index;          // Record after which the books disagreed
+    std::string check;     // apply, levels, mask, statistics, consistency, persistent or snapshot
+    std::string detail;
+};
+
+/**
+ * Swallow stderr while minimizing; ValidateConsistency reports every failing candidate
+ */
+class QuietStderr {
+private:
+    std::ostringstream sink_;
+    std::streambuf* saved_;
+
+public:
+    QuietStderr() : saved_(std::cerr.rdbuf(sink_.rdbuf())) {}
+    ~QuietStderr() { std::cerr.rdbuf(saved_); }
+};
+
+template <typename Book>
+std::string ApplyOutcome(Book& book, const MBORecord& record) {
+    try {
+        book.Apply(record);
+        return "applied";
+    } catch (const std::invalid_argument& e) {
+        return std::string("invalid_argument (") + e.what() + ")";
+    } catch (const std::runtime_error& e) {
+        return std::string("runtime_error (") + e.what() + ")";
+    } catch (const std::exception& e) {
+        return std::string("exception (") + e.what() + ")";
+    }
+}
+
+std::string ExceptionType(const std::string& outcome) {
+    return outcome.substr(0, outcome.find(' '));
+}
+
+std::string FormatLevels(const std::vector<ReferenceBook::Level>& levels) {
+    if (levels.empty()) {
+        return "(empty)";
+    }
+    std::string text;
+    for (const auto& level : levels) {
+        text += (text.empty() ? "" : " ") + utils::FormatPrice(level.price) + "x" + std::to_string(level.size) + "/" +
+                std::to_string(level.count);
+    }
+    return text;
+}
+
+std::vector<ReferenceBook::Level> ToLevels(const std::vector<CompactPriceLevel>& levels) {
+    std::vector<ReferenceBook::Level> result;
+    for (const auto& level : levels) {
+        result.push_back(ReferenceBook::Level{level.price, level.size, level.count});
+    }
+    return result;
+}
+
+bool SameLevel(const ReferenceBook::Level& a, const ReferenceBook::Level& b) {
+    return a.price == b.price && a.size == b.size && a.count == b.count;
+}
+
+bool SameLevels(const std::vector<ReferenceBook::Level>& a, const std::vector<ReferenceBook::Level>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), SameLevel);
+}
+
+/**
+ * Visible slot i of a side, empty past the end
+ */
+ReferenceBook::Level Slot(const std::vector<ReferenceBook::Level>& levels, size_t i) {
+    return i < levels.size() ? levels[i] : ReferenceBook::Level{};
+}
+
+/**
+ * Every level of a snapshot side, best first
+ */
+std::vector<ReferenceBook::Level> AllLevels(const OrderBookSnapshot& snapshot, char side) {
+    std::vector<ReferenceBook::Level> result;
+    snapshot.ForEachLevel(side, [&result](const CompactPriceLevel& level) {
+        result.push_back(ReferenceBook::Level{level.price, level.size, level.count});
+    });
+    return result;
+}
+
+/**
+ * Replay records through OrderBook, PersistentOrderBook and the reference,
+ * checking after every record
+ */
+std::optional<Divergence> Replay(const std::vector<MBORecord>& records, uint64_t validate_every) {
+    OrderBook book;
+    PersistentOrderBook persistent;
+    ReferenceBook reference;
+    std::vector<ReferenceBook::Level> seen[2];   // Reference levels as of the last consumed mask
+    
+    // A snapshot held across validation intervals, with its levels when taken
+    OrderBookSnapshot held = persistent.Snapshot();
+    std::vector<ReferenceBook::Level> held_levels[2];
+    
+    for (size_t i = 0; i < records.size(); ++i) {
+        const MBORecord& record = records[i];
+        std::string book_outcome = ApplyOutcome(book, record);
+        std::string persistent_outcome = ApplyOutcome(persistent, record);
+        std::string reference_outcome = ApplyOutcome(reference, record);
+        if (ExceptionType(book_outcome) != ExceptionType(reference_outcome)) {
+            return Divergence{i, "apply", "OrderBook " + book_outcome + ", reference " + reference_outcome};
+        }
+        if (ExceptionType(persistent_outcome) != ExceptionType(reference_outcome)) {
+            return Divergence{i, "persistent", "PersistentOrderBook " + persistent_outcome + ", reference " +
+                              reference_outcome};
+        }
+        
+        std::vector<ReferenceBook::Level> expected[2] = {reference.TopLevels(BID_SIDE, MBP_LEVELS),
+                                                         reference.TopLevels(ASK_SIDE, MBP_LEVELS)};
+        std::vector<ReferenceBook::Level> actual[2] = {ToLevels(book.GetTopBids(MBP_LEVELS)),
+                                                       ToLevels(book.GetTopAsks(MBP_LEVELS))};
+        OrderBookSnapshot snapshot = persistent.Snapshot();
+        for (int side = 0; side < 2; ++side) {
+            if (!SameLevels(actual[side], expected[side])) {
+                return Divergence{i, "levels", std::string(side == 0 ? "bids" : "asks") + "\n    OrderBook: " +
+                                  FormatLevels(actual[side]) + "\n    reference: " + FormatLevels(expected[side])};
+            }
+            auto persistent_levels = ToLevels(snapshot.GetTopLevels(side == 0 ? BID_SIDE : ASK_SIDE, MBP_LEVELS));
+            if (!SameLevels(persistent_levels, expected[side])) {
+                return Divergence{i, "persistent", std::string(side == 0 ? "bids" : "asks") +
+                                  "\n    PersistentOrderBook: " + FormatLevels(persistent_levels) +
+                                  "\n    reference: " + FormatLevels(expected[side])};
+            }
+        }
+        if (snapshot.OrderCount() != reference.OrderCount()) {
+            return Divergence{i, "persistent", "PersistentOrderBook " + std::to_string(snapshot.OrderCount()) +
+                              " orders, reference " + std::to_string(reference.OrderCount())};
+        }
+        
+        // Every visible slot that changed since the last consumed mask must be flagged in it
+        LevelMask changed = book.ConsumeChangedLevels();
+        for (int side = 0; side < 2; ++side) {
+            for (size_t slot = 0; slot < MBP_LEVELS; ++slot) {
+                LevelMask bit = LevelMask{1} << (slot + (side == 0 ? 0 : MBP_LEVELS));
+                if (!SameLevel(Slot(seen[side], slot), Slot(expected[side], slot)) && (changed & bit) == 0) {
+                    std::ostringstream detail;
+                    detail << (side == 0 ? "bid" : "ask") << " level " << slot
+                           << " changed but is not flagged in mask 0x" << std::hex << changed;
+                    return Divergence{i, "mask", detail.str()};
+                }
+            }
+            seen[side] = std::move(expected[side]);
+        }
+        
+        auto stats = book.GetStatistics();
+        Price best_bid = seen[0].empty() ? kUndefPrice : seen[0].front().price;
+        Price best_ask = seen[1].empty() ? kUndefPrice : seen[1].front().price;
+        if (stats.total_orders != reference.OrderCount() || stats.best_bid != best_bid || stats.best_ask != best_ask) {
+            return Divergence{i, "statistics", "OrderBook " + std::to_string(stats.total_orders) + " orders, best " +
+                              utils::FormatPrice(stats.best_bid) + " / " + utils::FormatPrice(stats.best_ask) +
+                              "; reference " + std::to_string(reference.OrderCount()) + " orders, best " +
+                              utils::FormatPrice(best_bid) + " / " + utils::FormatPrice(best_ask)};
+        }
+        
+        if ((i + 1) % validate_every == 0 || i + 1 == records.size()) {
+            size_t bid_levels = reference.LevelCount(BID_SIDE);
+            size_t ask_levels = reference.LevelCount(ASK_SIDE);
+            if (stats.total_bid_levels != bid_levels || stats.total_ask_levels != ask_levels) {
+                return Divergence{i, "statistics", "OrderBook " + std::to_string(stats.total_bid_levels) + " / " +
+                                  std::to_string(stats.total_ask_levels) + " levels, reference " +
+                                  std::to_string(bid_levels) + " / " + std::to_string(ask_levels)};
+            }
+            if (!book.ValidateConsistency()) {
+                return Divergence{i, "consistency", "OrderBook::ValidateConsistency failed (see stderr)"};
+            }
+            
+            // The held snapshot must not have seen any record since it was taken;
+            // the new one must match the reference at full depth
+            for (int side = 0; side < 2; ++side) {
+                char side_code = side == 0 ? BID_SIDE : ASK_SIDE;
+                auto held_now = AllLevels(held, side_code);
+                if (!SameLevels(held_now, held_levels[side])) {
+                    return Divergence{i, "snapshot", std::string(side == 0 ? "bids" : "asks") +
+                                      " of the snapshot at version " + std::to_string(held.Version()) +
+                                      " changed\n    when taken: " + FormatLevels(held_levels[side]) +
+                                      "\n    now: " + FormatLevels(held_now)};
+                }
+                held_levels[side] = AllLevels(snapshot, side_code);
+                auto full_depth = reference.TopLevels(side_code, reference.LevelCount(side_code));
+                if (!SameLevels(held_levels[side], full_depth)) {
+                    return Divergence{i, "persistent", std::string(side == 0 ? "bids" : "asks") +
+                                      " at full depth\n    PersistentOrderBook: " + FormatLevels(held_levels[side]) +
+                                      "\n    reference: " + FormatLevels(full_depth)};
+                }
+            }
+            held = snapshot;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * Delta debugging: drop chunks of records while the same check still fails
+ * @param tests Incremented per replay; stops early once it reaches max_tests
+ */
+std::vector<MBORecord> Minimize(std::vector<MBORecord> records, const std::string& check, uint64_t validate_every,
+                                uint64_t max_tests, uint64_t& tests) {
+    QuietStderr quiet;
+    size_t granularity = 2;
+    while (records.size() >= 2 && tests < max_tests) {
+        size_t chunk = (records.size() + granularity - 1) / granularity;
+        bool reduced = false;
+        for (size_t start = 0; start < records.size() && tests < max_tests; start += chunk) {
+            std::vector<MBORecord> candidate(records.begin(), records.begin() + start);
+            candidate.insert(candidate.end(), records.begin() + std::min(start + chunk, records.size()),
+                             records.end());
+            tests++;
+            auto divergence = Replay(candidate, validate_every);
+            if (divergence && divergence->check == check) {
+                candidate.resize(divergence->index + 1);
+                records = std::move(candidate);
+                granularity = std::max<size_t>(granularity - 1, 2);
+                reduced = true;
+                break;
+            }
+        }
+        if (!reduced) {
+            if (granularity >= records.size()) {
+                break;
+            }
+            granularity = std::min(granularity * 2, records.size());
+        }
+    }
+    return records;
+}
+
+std::vector<MBORecord> LoadCSV(const std::string& filename, uint64_t& skipped) {
+    LineReader input(filename);
+    std::string_view line;
+    if (!input.ReadLine(line)) {
+        throw std::runtime_error("Input file is empty or cannot be read: " + filename);
+    }
+    std::vector<MBORecord> records;
+    while (input.ReadLine(line)) {
+        try {
+            records.push_back(MBORecord::Parse(line));
+        } catch (const std::exception&) {
+            skipped++;
+        }
+    }
+    return records;
+}
+
+/**
+ * Generated stream for one seed; seeds rotate through order ID patterns,
+ * action mixes and book depths, and hostile records are mixed in
+ */
+std::vector<MBORecord> Generate(const DiffConfig& config, uint64_t seed, std::string& description) {
+    static const OrderIdPattern kPatterns[] = {OrderIdPattern::Sequential, OrderIdPattern::Random,
+                                               OrderIdPattern::Recycled};
+    static const char* const kPatternNames[] = {"sequential", "random", "recycled"};
+    uint64_t variant = seed - config.first_seed;
+    
+    GeneratorConfig generator_config;
+    generator_config.records = config.records;
+    generator_config.seed = seed;
+    generator_config.order_ids = kPatterns[variant % 3];
+    if (variant % 2 == 1) {
+        generator_config.add_weight = 0.40;
+        generator_config.cancel_weight = 0.30;
+        generator_config.modify_weight = 0.25;
+    }
+    bool thin = variant % 4 >= 2;
+    if (thin) {
+        // Few orders near the visible depth: levels appear and vanish at the top-N boundary
+        generator_config.target_orders = 60;
+        generator_config.depth = 12;
+    }
+    description = "seed " + std::to_string(seed) + ", " + kPatternNames[variant % 3] + " ids, " +
+                  (variant % 2 == 1 ? "modify-heavy" : "default mix") + (thin ? ", thin book" : "");
+    
+    MBOGenerator generator(generator_config);
+    std::mt19937_64 rng(seed ^ 0x9e3779b97f4a7c15ULL);
+    auto chance = [&rng](double p) { return static_cast<double>(rng() >> 11) * 0x1.0p-53 < p; };
+    std::vector<OrderID> ids;              // Recently added IDs, live or not
+    std::vector<MBORecord> records;
+    MBORecord record;
+    while (generator.Next(record)) {
+        records.push_back(record);
+        if (record.action == ACTION_ADD) {
+            if (ids.size() < 1024) {
+                ids.push_back(record.order_id);
+            } else {
+                ids[rng() % ids.size()] = record.order_id;
+            }
+        }
+        if (ids.empty() || !chance(config.mutate)) {
+            continue;
+        }
+        
+        // Hostile record: duplicate adds, stale cancels, side and price moves, invalid values
+        MBORecord hostile = record;
+        hostile.order_id = ids[rng() % ids.size()];
+        hostile.side = (rng() & 1) ? BID_SIDE : ASK_SIDE;
+        hostile.price = std::max<Price>(record.price == kUndefPrice ? 5510000000 : record.price, 20000000) +
+                        (static_cast<Price>(rng() % 5) - 2) * 10000000;
+        hostile.size = static_cast<Size>(1 + rng() % 500);
+        switch (rng() % 6) {
+            case 0: hostile.action = ACTION_ADD; break;
+            case 1: hostile.action = ACTION_CANCEL; break;
+            case 2: hostile.action = ACTION_MODIFY; break;
+            case 3: hostile.action = ACTION_MODIFY; hostile.side = NEUTRAL_SIDE; break;
+            case 4: hostile.action = (rng() & 1) ? ACTION_ADD : ACTION_MODIFY; hostile.size = 0; break;
+            default:
+                // Clears are rare so the book can build up depth again
+                hostile.action = (rng() % 20 == 0) ? ACTION_CLEAR : ACTION_CANCEL;
+                break;
+        }
+        records.push_back(hostile);
+    }
+    return records;
+}
+
+/**
+ * @return False if the books diverged (after reporting and minimizing)
+ */
+bool RunStream(const std::string& name, const std::vector<MBORecord>& records, const DiffConfig& config) {
+    auto start_time = std::chrono::steady_clock::now();
+    auto divergence = Replay(records, config.validate_every);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    if (!divergence) {
+        std::cout << "PASS " << name << ": " << records.size() << " records in " << seconds << "s\n";
+        return true;
+    }
+    
+    std::string line;
+    mbo_generator::AppendCSV(records[divergence->index], line);
+    std::cout << "FAIL " << name << ": " << divergence->check << " diverged at record " << divergence->index << "\n";
+    std::cout << "  " << line;
+    std::cout << "  " << divergence->detail << "\n";
+    
+    // Nothing after the divergence is needed to reproduce it
+    std::vector<MBORecord> prefix(records.begin(), records.begin() + divergence->index + 1);
+    uint64_t tests = 0;
+    auto minimized = Minimize(std::move(prefix), divergence->check, config.validate_every, config.max_tests, tests);
+    auto final_divergence = Replay(minimized, config.validate_every);
+    
+    std::string csv = std::string(mbo_generator::kCSVHeader) + "\n";
+    for (const auto& record : minimized) {
+        mbo_generator::AppendCSV(record, csv);
+    }
+    std::cout << "Minimized to " << minimized.size() << " records after " << tests << " replays"
+              << (tests >= config.max_tests ? " (budget exhausted)" : "") << ":\n";
+    std::cout << csv;
+    if (final_divergence) {
+        std::cout << "  " << final_divergence->check << " at record " << final_divergence->index << ": "
+                  << final_divergence->detail << "\n";
+    }
+    if (!config.out_file.empty()) {
+        std::ofstream out(config.out_file);
+        if (!out.is_open() || !(out << csv)) {
+            throw std::runtime_error("Failed to write " + config.out_file);
+        }
+        std::cout << "Reproduction written to " << config.out_file << " (replay with --input)\n";
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        DiffConfig config;
+        bool seeds_given = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--input" && i + 1 < argc) {
+                config.inputs.push_back(argv[++i]);
+            } else if (arg == "--seeds" && i + 1 < argc) {
+                config.seeds = std::stoull(argv[++i]);
+                seeds_given = true;
+            } else if (arg == "--first-seed" && i + 1 < argc) {
+                config.first_seed = std::stoull(argv[++i]);
+            } else if (arg == "--records" && i + 1 < argc) {
+                config.records = std::stoull(argv[++i]);
+            } else if (arg == "--mutate" && i + 1 < argc) {
+                config.mutate = std::stod(argv[++i]);
+            } else if (arg == "--validate-every" && i + 1 < argc) {
+                config.validate_every = std::stoull(argv[++i]);
+            } else if (arg == "--max-tests" && i + 1 < argc) {
+                config.max_tests = std::stoull(argv[++i]);
+            } else if (arg == "--out" && i + 1 < argc) {
+                config.out_file = argv[++i];
+            } else {
+                PrintUsage(argv[0]);
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+        if (config.validate_every == 0) {
+            throw std::invalid_argument("--validate-every must be positive");
+        }
+        if (config.mutate < 0 || config.mutate > 1) {
+            throw std::invalid_argument("--mutate must be between 0 and 1");
+        }
+        // Replaying a reproduction should not also run the generated streams
+        if (!config.inputs.empty() && !seeds_given) {
+            config.seeds = 0;
+        }
+        
+        for (const auto& input : config.inputs) {
+            uint64_t skipped = 0;
+            auto records = LoadCSV(input, skipped);
+            if (skipped > 0) {
+                std::cout << input << ": skipped " << skipped << " unparsable lines\n";
+            }
+            if (!RunStream(input, records, config)) {
+                return 1;
+            }
+        }
+        for (uint64_t seed = config.first_seed; seed < config.first_seed + config.seeds; ++seed) {
+            std::string description;
+            auto records = Generate(config, seed, description);
+            if (!RunStream("generated (" + description + ")", records, config)) {
+                return 1;
+            }
+        }
+        std::cout << "OrderBook and PersistentOrderBook match the reference on every stream\n";
+        return 0;
+    
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
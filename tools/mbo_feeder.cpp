@@ -0,0 +1,189 @@
+#include "line_reader.h"
+#include "mbo_binary.h"
+#include "records.h"
+#include "utils.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+void PrintUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <mbo_file> <unix:/path | fifo> [--format csv|binary] [--rate N] [--loop N]\n";
+    std::cout << "\n";
+    std::cout << "Description:\n";
+    std::cout << "  Replays an MBO CSV file into a Unix domain socket or FIFO, for testing live ingestion.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --format csv|binary  Framing to send (default: csv)\n";
+    std::cout << "  --rate N             Records per second (default: 0 = as fast as possible)\n";
+    std::cout << "  --loop N             Replay the file N times (default: 1)\n";
+}
+
+/**
+ * Connect to a listening Unix socket, retrying while the server starts up
+ */
+int ConnectSocket(const std::string& path) {
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid Unix socket path: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("Failed to create socket: ") + std::strerror(errno));
+        }
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    throw std::runtime_error("Failed to connect to " + path + ": " + std::strerror(errno));
+}
+
+/**
+ * Encoded messages for every record of the input file
+ */
+struct Replay {
+    std::string header;                 // Sent once per connection
+    std::vector<std::string> messages;
+};
+
+Replay LoadReplay(const std::string& filename, bool binary) {
+    Replay replay;
+    LineReader input(filename);
+    std::string_view line;
+    
+    if (!input.ReadLine(line)) {
+        throw std::runtime_error("Input file is empty: " + filename);
+    }
+    if (!binary) {
+        replay.header.assign(line.data(), line.size());
+        replay.header += '\n';
+    }
+    
+    std::string symbol;
+    while (input.ReadLine(line)) {
+        if (!binary) {
+            replay.messages.emplace_back(line.data(), line.size());
+            replay.messages.back() += '\n';
+            continue;
+        }
+        MBORecord record = MBORecord::Parse(line);
+        if (symbol.empty()) {
+            symbol = record.symbol;
+        }
+        mbo_binary::MBOMsg message = mbo_binary::Encode(record);
+        replay.messages.emplace_back(reinterpret_cast<const char*>(&message), sizeof(message));
+    }
+    
+    if (binary) {
+        mbp_binary::FileHeader header = mbo_binary::MakeHeader(symbol);
+        replay.header.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    return replay;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 3) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        
+        std::string input_file = argv[1];
+        std::string target = argv[2];
+        bool binary = false;
+        uint64_t rate = 0;
+        uint64_t loops = 1;
+        
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--format" && i + 1 < argc) {
+                std::string format = argv[++i];
+                if (format != "csv" && format != "binary") {
+                    throw std::invalid_argument("Unknown format: " + format);
+                }
+                binary = (format == "binary");
+            } else if (arg == "--rate" && i + 1 < argc) {
+                rate = std::stoull(argv[++i]);
+            } else if (arg == "--loop" && i + 1 < argc) {
+                loops = std::stoull(argv[++i]);
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        
+        Replay replay = LoadReplay(input_file, binary);
+        
+        // A reader that goes away should end the replay with an error, not a signal
+        std::signal(SIGPIPE, SIG_IGN);
+        
+        int fd;
+        if (target.compare(0, 5, "unix:") == 0) {
+            fd = ConnectSocket(target.substr(5));
+        } else {
+            fd = ::open(target.c_str(), O_WRONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("Failed to open " + target + ": " + std::strerror(errno));
+            }
+        }
+        
+        auto start_time = std::chrono::steady_clock::now();
+        uint64_t interval_ns = rate > 0 ? 1000000000ULL / rate : 0;
+        uint64_t sent = 0;
+        std::string batch;
+        
+        utils::WriteFully(fd, replay.header.data(), replay.header.size());
+        for (uint64_t loop = 0; loop < loops; ++loop) {
+            for (const auto& message : replay.messages) {
+                if (interval_ns == 0) {
+                    // Unpaced: coalesce into large writes
+                    batch += message;
+                    if (batch.size() >= BUFFER_SIZE) {
+                        utils::WriteFully(fd, batch.data(), batch.size());
+                        batch.clear();
+                    }
+                } else {
+                    // Paced: one write per record at its scheduled send time
+                    auto due = start_time + std::chrono::nanoseconds(sent * interval_ns);
+                    while (std::chrono::steady_clock::now() < due) {
+                        auto remaining = due - std::chrono::steady_clock::now();
+                        if (remaining > std::chrono::microseconds(100)) {
+                            std::this_thread::sleep_for(remaining - std::chrono::microseconds(50));
+                        }
+                    }
+                    utils::WriteFully(fd, message.data(), message.size());
+                }
+                ++sent;
+            }
+        }
+        utils::WriteFully(fd, batch.data(), batch.size());
+        ::close(fd);
+        
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+        std::cout << "Sent " << sent << " records in " << duration.count() << "ms";
+        if (duration.count() > 0) {
+            std::cout << " (" << sent * 1000 / duration.count() << " records/sec)";
+        }
+        std::cout << "\n";
+        return 0;
+    
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,186 @@
+#include "mbo_binary.h"
+#include "mbo_generator.h"
+#include "utils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+void PrintUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <output_file | -> [options]\n";
+    std::cout << "\n";
+    std::cout << "Description:\n";
+    std::cout << "  Writes a seeded synthetic MBO stream (CSV input format or binary MBO stream)\n";
+    std::cout << "  for scale tests and benchmarks. The same options and seed give the same file.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --records N          Book records after the opening clear records (default: 1000000)\n";
+    std::cout << "  --format csv|binary  Output framing (default: binary for .bin files, else csv)\n";
+    std::cout << "  --instruments N      Instruments, picked uniformly per event (default: 1)\n";
+    std::cout << "  --symbol NAME        Symbol of the first instrument (default: SYN)\n";
+    std::cout << "  --mix A:C:M:T        Add / cancel / modify / trade weights (default: 50:40:5:5)\n";
+    std::cout << "  --start-price P      Initial mid price (default: 5.51)\n";
+    std::cout << "  --tick P             Tick size (default: 0.01)\n";
+    std::cout << "  --walk P             Per event chance the mid moves one tick (default: 0.01)\n";
+    std::cout << "  --depth N            Orders rest within N ticks of the mid (default: 20)\n";
+    std::cout << "  --target-orders N    Resting orders per instrument to steer towards (default: 2000)\n";
+    std::cout << "  --max-size N         Largest order size (default: 500)\n";
+    std::cout << "  --order-ids PATTERN  sequential, random or recycled (default: sequential)\n";
+    std::cout << "  --gap DURATION       Mean time between events, e.g. 50us (default: 50us)\n";
+    std::cout << "  --event-records X    Mean records per event (default: 1.5)\n";
+    std::cout << "  --burst-prob P       Per event chance of a burst (default: 0.001)\n";
+    std::cout << "  --burst-events N     Events per burst (default: 200)\n";
+    std::cout << "  --burst-speedup N    Gap divisor inside bursts (default: 100)\n";
+    std::cout << "  --seed N             Random seed (default: 1)\n";
+    std::cout << "\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << program_name << " data/mbo_10m.csv --records 10000000 --order-ids random --seed 7\n";
+}
+
+/**
+ * Parse "50:40:5:5" into the four action weights
+ */
+void ParseMix(const std::string& mix, GeneratorConfig& config) {
+    double weights[4];
+    size_t start = 0;
+    for (int i = 0; i < 4; ++i) {
+        size_t end = mix.find(':', start);
+        if ((i < 3) == (end == std::string::npos)) {
+            throw std::invalid_argument("Invalid --mix (expected A:C:M:T): " + mix);
+        }
+        weights[i] = std::stod(mix.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        start = end + 1;
+    }
+    config.add_weight = weights[0];
+    config.cancel_weight = weights[1];
+    config.modify_weight = weights[2];
+    config.trade_weight = weights[3];
+}
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
+            PrintUsage(argv[0]);
+            return argc < 2 ? 1 : 0;
+        }
+
+        std::string output_file = argv[1];
+        bool binary = EndsWith(output_file, ".bin");
+        GeneratorConfig config;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (arg == "--records") {
+                config.records = std::stoull(value);
+            } else if (arg == "--format") {
+                if (value != "csv" && value != "binary") {
+                    throw std::invalid_argument("Unknown format: " + value);
+                }
+                binary = value == "binary";
+            } else if (arg == "--instruments") {
+                config.instruments = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--symbol") {
+                config.symbol = value;
+            } else if (arg == "--mix") {
+                ParseMix(value, config);
+            } else if (arg == "--start-price") {
+                config.start_price = utils::ParsePrice(value);
+            } else if (arg == "--tick") {
+                config.tick_size = utils::ParsePrice(value);
+            } else if (arg == "--walk") {
+                config.walk_probability = std::stod(value);
+            } else if (arg == "--depth") {
+                config.depth = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--target-orders") {
+                config.target_orders = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--max-size") {
+                config.max_size = static_cast<Size>(std::stoul(value));
+            } else if (arg == "--order-ids") {
+                config.order_ids = ParseOrderIdPattern(value);
+            } else if (arg == "--gap") {
+                config.mean_gap_ns = utils::ParseDuration(value);
+            } else if (arg == "--event-records") {
+                config.mean_event_records = std::stod(value);
+            } else if (arg == "--burst-prob") {
+                config.burst_probability = std::stod(value);
+            } else if (arg == "--burst-events") {
+                config.burst_events = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--burst-speedup") {
+                config.burst_speedup = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--seed") {
+                config.seed = std::stoull(value);
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+
+        MBOGenerator generator(config);
+
+        bool to_stdout = output_file == "-";
+        std::FILE* out = to_stdout ? stdout : std::fopen(output_file.c_str(), "wb");
+        if (out == nullptr) {
+            throw std::runtime_error("Failed to open output file: " + output_file);
+        }
+
+        std::string buffer;
+        buffer.reserve(2 * 1024 * 1024);
+        uint64_t bytes = 0;
+        auto flush = [&] {
+            if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) {
+                throw std::runtime_error("Failed to write " + output_file);
+            }
+            bytes += buffer.size();
+            buffer.clear();
+        };
+
+        if (binary) {
+            // Multi-instrument streams keep per-record instrument IDs; the header names the first symbol
+            mbp_binary::FileHeader header = mbo_binary::MakeHeader(config.symbol);
+            buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        } else {
+            buffer += mbo_generator::kCSVHeader;
+            buffer += '\n';
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        MBORecord record;
+        while (generator.Next(record)) {
+            if (binary) {
+                mbo_binary::MBOMsg message = mbo_binary::Encode(record);
+                buffer.append(reinterpret_cast<const char*>(&message), sizeof(message));
+            } else {
+                mbo_generator::AppendCSV(record, buffer);
+            }
+            if (buffer.size() >= 1024 * 1024) {
+                flush();
+            }
+        }
+        flush();
+        if (std::fflush(out) != 0 || (!to_stdout && std::fclose(out) != 0)) {
+            throw std::runtime_error("Failed to write " + output_file);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        std::cerr << "Generated " << generator.Generated() << " records (" << bytes / (1024.0 * 1024.0) << " MB, "
+                  << (binary ? "binary" : "csv") << ") in " << seconds << "s, "
+                  << static_cast<uint64_t>(generator.Generated() / std::max(seconds, 1e-9)) << " records/sec; "
+                  << generator.RestingOrders() << " orders resting at the end\n";
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
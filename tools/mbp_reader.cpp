@@ -0,0 +1,247 @@
+#include "mbp_binary.h"
+#include "mbp_columnar.h"
+#include "mbp_delta.h"
+#include "utils.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void PrintUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <mbp_file> [--info] [--row N] [--count N] [--columns a,b,...]\n";
+    std::cout << "\n";
+    std::cout << "Description:\n";
+    std::cout << "  Prints records of a binary MBP-10, columnar or delta MBP file as CSV in the converter's\n";
+    std::cout << "  output shape: a header, then the row index and the row's columns. Binary files\n";
+    std::cout << "  carry no order_id (printed as 0) and one symbol for the whole file. Delta files are\n";
+    std::cout << "  replayed into full rows with the columns the delta format carries.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --info            Print the file header / footer summary only\n";
+    std::cout << "  --row N           First row to print (default: 0)\n";
+    std::cout << "  --count N         Number of rows to print (default: all)\n";
+    std::cout << "  --columns a,b     Columns to materialize (columnar files only, default: all)\n";
+}
+
+/**
+ * Read the 4-byte magic at the start of a file
+ */
+std::string ReadMagic(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[4] = {};
+    file.read(magic, sizeof(magic));
+    return std::string(magic, sizeof(magic));
+}
+
+std::string FormatValue(int64_t value, mbp_columnar::ColumnKind kind, const std::vector<std::string>& symbols) {
+    switch (kind) {
+        case mbp_columnar::ColumnKind::Price:
+            return utils::FormatPrice(value);
+        case mbp_columnar::ColumnKind::Timestamp:
+            return utils::FormatTimestamp(static_cast<Timestamp>(value));
+        case mbp_columnar::ColumnKind::Char:
+            return std::string(1, static_cast<char>(value));
+        case mbp_columnar::ColumnKind::Symbol:
+            return static_cast<size_t>(value) < symbols.size() ? symbols[value] : "";
+        case mbp_columnar::ColumnKind::Integer:
+            break;
+    }
+    return std::to_string(value);
+}
+
+/**
+ * Header in the converter's CSV shape: an unnamed index column, then the columns
+ */
+void PrintHeader(const std::vector<std::string>& columns) {
+    for (const auto& name : columns) {
+        std::cout << ',' << name;
+    }
+    std::cout << '\n';
+}
+
+void DumpBinary(const std::string& filename, bool info_only, uint64_t first_row, uint64_t row_count) {
+    MBPBinaryReader reader(filename);
+    
+    if (info_only) {
+        std::cout << "Format:      binary MBP-10\n";
+        std::cout << "Records:     " << reader.RecordCount() << "\n";
+        std::cout << "Record size: " << sizeof(mbp_binary::MBP10Record) << " bytes\n";
+        std::cout << "Symbol:      " << reader.Symbol() << "\n";
+        return;
+    }
+    
+    std::vector<std::string> columns;
+    for (const auto& info : mbp_columnar::Schema()) {
+        columns.push_back(info.name);
+    }
+    PrintHeader(columns);
+    
+    uint64_t end_row = reader.RecordCount();
+    if (row_count < end_row - std::min(first_row, end_row)) {
+        end_row = first_row + row_count;
+    }
+    
+    for (uint64_t row = first_row; row < end_row; ++row) {
+        std::cout << row << reader.Read(row).ToCSV() << '\n';
+    }
+}
+
+void DumpColumnar(const std::string& filename, bool info_only, uint64_t first_row, uint64_t row_count,
+                  std::vector<std::string> columns) {
+    MBPColumnarReader reader(filename);
+    const auto& schema = mbp_columnar::Schema();
+    
+    if (info_only) {
+        std::cout << "Format:      columnar MBP\n";
+        std::cout << "Rows:        " << reader.RowCount() << "\n";
+        std::cout << "Row groups:  " << reader.RowGroups().size() << "\n";
+        for (size_t g = 0; g < reader.RowGroups().size(); ++g) {
+            const auto& group = reader.RowGroups()[g];
+            std::cout << "Row group " << g << ": " << group.row_count << " rows\n";
+            for (size_t c = 0; c < schema.size(); ++c) {
+                const auto& chunk = group.columns[c];
+                std::cout << "  " << schema[c].name << ": " << chunk.length << " bytes";
+                if (chunk.null_count < group.row_count) {
+                    std::cout << ", min " << FormatValue(chunk.min_value, schema[c].kind, reader.Symbols())
+                              << ", max " << FormatValue(chunk.max_value, schema[c].kind, reader.Symbols());
+                }
+                if (chunk.null_count > 0) {
+                    std::cout << ", " << chunk.null_count << " empty";
+                }
+                std::cout << "\n";
+            }
+        }
+        return;
+    }
+    
+    if (columns.empty()) {
+        for (const auto& info : schema) {
+            columns.push_back(info.name);
+        }
+    }
+    
+    auto values = reader.ReadColumns(columns);
+    std::vector<mbp_columnar::ColumnKind> kinds;
+    for (const auto& name : columns) {
+        kinds.push_back(schema[MBPColumnarReader::ColumnIndex(name)].kind);
+    }
+    
+    PrintHeader(columns);
+    
+    uint64_t end_row = reader.RowCount();
+    if (row_count < end_row - std::min(first_row, end_row)) {
+        end_row = first_row + row_count;
+    }
+    
+    for (uint64_t row = first_row; row < end_row; ++row) {
+        std::cout << row;
+        for (size_t c = 0; c < columns.size(); ++c) {
+            std::cout << ',' << FormatValue(values[c][row], kinds[c], reader.Symbols());
+        }
+        std::cout << '\n';
+    }
+}
+
+void DumpDelta(const std::string& filename, bool info_only, uint64_t first_row, uint64_t row_count) {
+    MBPDeltaReader reader(filename);
+    uint64_t index = 0;
+    uint64_t rows = 0;
+    MBPRecord record;
+    
+    if (info_only) {
+        while (reader.Next(index, record)) {
+            rows++;
+        }
+        std::cout << "Format:      delta MBP\n";
+        std::cout << "Rows:        " << rows << "\n";
+        return;
+    }
+    
+    // The converter's columns that the delta format carries, in CSV order
+    std::vector<std::string> columns;
+    for (const auto& info : mbp_columnar::Schema()) {
+        const std::string& name = info.name;
+        if (name == "ts_event" || name == "action" || name == "side" || name == "price" || name == "size" ||
+            name == "flags" || name == "sequence" || name == "order_id" || name.compare(0, 4, "bid_") == 0 ||
+            name.compare(0, 4, "ask_") == 0) {
+            columns.push_back(name);
+        }
+    }
+    PrintHeader(columns);
+    
+    // Rows before first_row still have to be replayed for their levels
+    while (rows - std::min(rows, first_row) < row_count && reader.Next(index, record)) {
+        if (rows++ < first_row) {
+            continue;
+        }
+        std::cout << index << ',' << record.ts_event << ',' << record.action << ',' << record.side << ','
+                  << utils::FormatPrice(record.price) << ',' << record.size << ',' << static_cast<int>(record.flags)
+                  << ',' << record.sequence;
+        for (int i = 0; i < MBP_LEVELS; ++i) {
+            for (const auto& level : {record.GetBidLevel(i), record.GetAskLevel(i)}) {
+                std::cout << ',' << utils::FormatPrice(level.price) << ',' << level.size << ',' << level.count;
+            }
+        }
+        std::cout << ',' << record.order_id << '\n';
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        utils::EnableFastIO();
+        
+        if (argc < 2) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        
+        std::string filename = argv[1];
+        bool info_only = false;
+        uint64_t first_row = 0;
+        uint64_t row_count = UINT64_MAX;
+        std::vector<std::string> columns;
+        
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--info") {
+                info_only = true;
+            } else if (arg == "--row" && i + 1 < argc) {
+                first_row = std::stoull(argv[++i]);
+            } else if (arg == "--count" && i + 1 < argc) {
+                row_count = std::stoull(argv[++i]);
+            } else if (arg == "--columns" && i + 1 < argc) {
+                for (auto name : utils::SplitCSVLine(argv[++i])) {
+                    columns.emplace_back(name);
+                }
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        
+        std::string magic = ReadMagic(filename);
+        if (std::memcmp(magic.data(), mbp_columnar::MAGIC, sizeof(mbp_columnar::MAGIC)) == 0) {
+            DumpColumnar(filename, info_only, first_row, row_count, columns);
+        } else if (std::memcmp(magic.data(), mbp_binary::MAGIC, sizeof(mbp_binary::MAGIC)) == 0) {
+            if (!columns.empty()) {
+                throw std::invalid_argument("--columns is only supported for columnar files");
+            }
+            DumpBinary(filename, info_only, first_row, row_count);
+        } else if (magic == "inde") {
+            if (!columns.empty()) {
+                throw std::invalid_argument("--columns is only supported for columnar files");
+            }
+            DumpDelta(filename, info_only, first_row, row_count);
+        } else {
+            throw std::runtime_error("Unrecognized MBP file format: " + filename);
+        }
+        
+        return 0;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
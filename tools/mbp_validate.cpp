@@ -0,0 +1,407 @@
+#include "mapped_file.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+void PrintUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <actual_mbp.csv> <expected_mbp.csv> [options]\n";
+    std::cout << "\n";
+    std::cout << "Description:\n";
+    std::cout << "  Compares two MBP CSV files row by row and column by column. Numbers are\n";
+    std::cout << "  compared by value (5.9 == 5.90) and timestamps by the instant they denote.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --max-mismatches N  Mismatches to print in detail (default: 10)\n";
+    std::cout << "  --stop              Stop after the printed mismatches instead of scanning everything\n";
+    std::cout << "  --ignore a,b        Columns to skip\n";
+    std::cout << "  --mbo FILE          MBO input, used to locate the line each mismatching row came from\n";
+}
+
+/**
+ * Iterates over the lines of a mapped file without copying
+ */
+class LineCursor {
+private:
+    std::string_view data_;
+    size_t pos_{0};
+
+public:
+    explicit LineCursor(std::string_view data) : data_(data) {}
+    
+    bool Next(std::string_view& line) {
+        if (pos_ >= data_.size()) {
+            return false;
+        }
+        const char* begin = data_.data() + pos_;
+        const void* newline = std::memchr(begin, '\n', data_.size() - pos_);
+        size_t length = newline ? static_cast<const char*>(newline) - begin : data_.size() - pos_;
+        pos_ += length + 1;
+        
+        line = std::string_view(begin, length);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return true;
+    }
+};
+
+/**
+ * Split a line on commas into a reused vector (MBP fields are never quoted)
+ */
+void SplitFields(std::string_view line, std::vector<std::string_view>& fields) {
+    fields.clear();
+    while (true) {
+        const void* comma = std::memchr(line.data(), ',', line.size());
+        if (!comma) {
+            fields.push_back(line);
+            return;
+        }
+        size_t length = static_cast<const char*>(comma) - line.data();
+        fields.push_back(line.substr(0, length));
+        line.remove_prefix(length + 1);
+    }
+}
+
+bool IsDecimal(std::string_view value) {
+    size_t i = (!value.empty() && value[0] == '-') ? 1 : 0;
+    bool digits = false;
+    bool point = false;
+    for (; i < value.size(); ++i) {
+        if (value[i] >= '0' && value[i] <= '9') {
+            digits = true;
+        } else if (value[i] == '.' && !point) {
+            point = true;
+        } else {
+            return false;
+        }
+    }
+    return digits;
+}
+
+/**
+ * Drop trailing fractional zeros so that 5.9, 5.90 and 5.900000000 compare equal
+ */
+std::string_view TrimDecimal(std::string_view value) {
+    if (value.find('.') == std::string_view::npos) {
+        return value;
+    }
+    while (value.back() == '0') {
+        value.remove_suffix(1);
+    }
+    if (value.back() == '.') {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+bool LooksLikeTimestamp(std::string_view value) {
+    return value.size() >= 20 && value[4] == '-' && value[10] == 'T';
+}
+
+/**
+ * Numeric-aware field comparison; the byte-equal fast path covers almost every field
+ */
+bool FieldsEqual(std::string_view actual, std::string_view expected) {
+    if (actual == expected) {
+        return true;
+    }
+    if (IsDecimal(actual) && IsDecimal(expected)) {
+        return TrimDecimal(actual) == TrimDecimal(expected);
+    }
+    if (LooksLikeTimestamp(actual) && LooksLikeTimestamp(expected)) {
+        try {
+            return utils::ParseTimestamp(actual) == utils::ParseTimestamp(expected);
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return false;
+}
+
+struct Mismatch {
+    uint64_t row;
+    size_t column;
+    std::string actual;
+    std::string expected;
+    uint64_t sequence{0};
+    uint64_t order_id{0};
+    bool has_key{false};
+    uint64_t mbo_line{0};   // 0 when not located
+};
+
+struct ColumnSummary {
+    uint64_t mismatches{0};
+    uint64_t first_row{0};
+};
+
+struct ValidateOptions {
+    std::string actual_file;
+    std::string expected_file;
+    std::string mbo_file;
+    size_t max_report{10};
+    bool stop{false};
+    std::unordered_set<std::string> ignore;
+};
+
+std::vector<std::string> ColumnNames(std::string_view header) {
+    std::vector<std::string_view> fields;
+    SplitFields(header, fields);
+    
+    std::vector<std::string> names(fields.begin(), fields.end());
+    if (!names.empty() && names[0].empty()) {
+        names[0] = "index";   // The leading row-number column is unnamed
+    }
+    return names;
+}
+
+size_t FindColumn(const std::vector<std::string>& names, const std::string& name) {
+    auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? SIZE_MAX : static_cast<size_t>(it - names.begin());
+}
+
+uint64_t ParseKey(const std::vector<std::string_view>& fields, size_t column) {
+    if (column >= fields.size() || !IsDecimal(fields[column])) {
+        return 0;
+    }
+    return utils::ParseUint64(fields[column]);
+}
+
+/**
+ * Find the MBO line of each mismatch by its (sequence, order_id) pair in one pass
+ */
+void LocateMBOLines(const std::string& mbo_file, std::vector<Mismatch>& mismatches) {
+    std::unordered_map<uint64_t, std::vector<Mismatch*>> by_sequence;
+    for (auto& mismatch : mismatches) {
+        if (mismatch.has_key) {
+            by_sequence[mismatch.sequence].push_back(&mismatch);
+        }
+    }
+    if (by_sequence.empty()) {
+        return;
+    }
+    
+    MappedFile file(mbo_file);
+    LineCursor cursor(file.View());
+    std::string_view line;
+    if (!cursor.Next(line)) {
+        return;
+    }
+    auto names = ColumnNames(line);
+    size_t sequence_column = FindColumn(names, "sequence");
+    size_t order_id_column = FindColumn(names, "order_id");
+    if (sequence_column == SIZE_MAX || order_id_column == SIZE_MAX) {
+        throw std::runtime_error("MBO file has no sequence/order_id columns: " + mbo_file);
+    }
+    
+    std::vector<std::string_view> fields;
+    uint64_t line_number = 1;
+    while (cursor.Next(line)) {
+        ++line_number;
+        SplitFields(line, fields);
+        auto it = by_sequence.find(ParseKey(fields, sequence_column));
+        if (it == by_sequence.end()) {
+            continue;
+        }
+        uint64_t order_id = ParseKey(fields, order_id_column);
+        for (Mismatch* mismatch : it->second) {
+            if (mismatch->mbo_line == 0 && mismatch->order_id == order_id) {
+                mismatch->mbo_line = line_number;
+            }
+        }
+    }
+}
+
+int Validate(const ValidateOptions& options) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    MappedFile actual_file(options.actual_file);
+    MappedFile expected_file(options.expected_file);
+    LineCursor actual_cursor(actual_file.View());
+    LineCursor expected_cursor(expected_file.View());
+    
+    std::string_view actual_line;
+    std::string_view expected_line;
+    if (!actual_cursor.Next(actual_line) || !expected_cursor.Next(expected_line)) {
+        throw std::runtime_error("Both files need a CSV header");
+    }
+    
+    // Columns are matched by name, so column order may differ between the files
+    auto actual_names = ColumnNames(actual_line);
+    auto expected_names = ColumnNames(expected_line);
+    std::vector<size_t> compared;         // Expected column indices to check
+    std::vector<size_t> actual_index;     // Matching actual column for each expected column
+    actual_index.resize(expected_names.size(), SIZE_MAX);
+    for (size_t column = 0; column < expected_names.size(); ++column) {
+        if (options.ignore.count(expected_names[column])) {
+            continue;
+        }
+        size_t index = FindColumn(actual_names, expected_names[column]);
+        if (index == SIZE_MAX) {
+            throw std::runtime_error("Actual file has no column '" + expected_names[column] + "'");
+        }
+        actual_index[column] = index;
+        compared.push_back(column);
+    }
+    size_t sequence_column = FindColumn(actual_names, "sequence");
+    size_t order_id_column = FindColumn(actual_names, "order_id");
+    
+    std::vector<std::string_view> actual_fields;
+    std::vector<std::string_view> expected_fields;
+    std::vector<ColumnSummary> summary(expected_names.size());
+    std::vector<Mismatch> mismatches;
+    uint64_t rows = 0;
+    uint64_t mismatched_rows = 0;
+    uint64_t mismatched_fields = 0;
+    bool actual_more = true;
+    bool expected_more = true;
+    
+    while (true) {
+        actual_more = actual_cursor.Next(actual_line);
+        expected_more = expected_cursor.Next(expected_line);
+        if (!actual_more || !expected_more) {
+            break;
+        }
+        
+        // Identical lines are the common case and need no splitting
+        if (actual_line != expected_line) {
+            SplitFields(actual_line, actual_fields);
+            SplitFields(expected_line, expected_fields);
+            
+            bool row_differs = false;
+            for (size_t column : compared) {
+                size_t index = actual_index[column];
+                std::string_view actual = index < actual_fields.size() ? actual_fields[index] : std::string_view();
+                std::string_view expected = column < expected_fields.size() ? expected_fields[column] : std::string_view();
+                if (FieldsEqual(actual, expected)) {
+                    continue;
+                }
+                
+                row_differs = true;
+                ++mismatched_fields;
+                if (summary[column].mismatches++ == 0) {
+                    summary[column].first_row = rows;
+                }
+                if (mismatches.size() < options.max_report) {
+                    Mismatch mismatch{rows, column, std::string(actual), std::string(expected)};
+                    if (sequence_column != SIZE_MAX && order_id_column != SIZE_MAX) {
+                        mismatch.sequence = ParseKey(actual_fields, sequence_column);
+                        mismatch.order_id = ParseKey(actual_fields, order_id_column);
+                        mismatch.has_key = true;
+                    }
+                    mismatches.push_back(std::move(mismatch));
+                }
+            }
+            mismatched_rows += row_differs;
+        }
+        ++rows;
+        
+        if (options.stop && mismatches.size() >= options.max_report && mismatched_fields > 0) {
+            break;
+        }
+    }
+    
+    // Count whatever is left of the longer file
+    uint64_t actual_rows = rows + (actual_more ? 1 : 0);
+    uint64_t expected_rows = rows + (expected_more ? 1 : 0);
+    bool stopped = options.stop && mismatched_fields > 0 && actual_more && expected_more;
+    if (!stopped) {
+        while (actual_more && actual_cursor.Next(actual_line)) ++actual_rows;
+        while (expected_more && expected_cursor.Next(expected_line)) ++expected_rows;
+    }
+    
+    if (!options.mbo_file.empty()) {
+        LocateMBOLines(options.mbo_file, mismatches);
+    }
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    
+    std::cout << "Compared " << rows << " rows x " << compared.size() << " columns ("
+              << (actual_file.Size() + expected_file.Size()) / (1024 * 1024) << " MB) in "
+              << duration.count() << " ms" << (stopped ? " (stopped early)" : "") << "\n";
+    
+    if (!mismatches.empty()) {
+        std::cout << "\nFirst " << mismatches.size() << " mismatches:\n";
+        for (const auto& mismatch : mismatches) {
+            std::cout << "  row " << mismatch.row << " (line " << mismatch.row + 2 << ") "
+                      << expected_names[mismatch.column] << ": actual '" << mismatch.actual
+                      << "' expected '" << mismatch.expected << "'";
+            if (mismatch.mbo_line > 0) {
+                std::cout << " [MBO line " << mismatch.mbo_line << "]";
+            } else if (!options.mbo_file.empty()) {
+                std::cout << " [MBO line not found]";
+            }
+            std::cout << "\n";
+        }
+        
+        std::cout << "\nMismatches by column:\n";
+        for (size_t column : compared) {
+            if (summary[column].mismatches == 0) {
+                continue;
+            }
+            std::cout << "  " << std::left << std::setw(14) << expected_names[column] << std::right
+                      << std::setw(10) << summary[column].mismatches
+                      << "  (first at row " << summary[column].first_row << ")\n";
+        }
+    }
+    
+    bool row_count_differs = !stopped && actual_rows != expected_rows;
+    if (row_count_differs) {
+        std::cout << "\nRow count differs: actual " << actual_rows << ", expected " << expected_rows << "\n";
+    }
+    
+    if (mismatched_fields == 0 && !row_count_differs) {
+        std::cout << "Result: OK\n";
+        return 0;
+    }
+    std::cout << "Result: FAIL (" << mismatched_fields << " fields in " << mismatched_rows << " rows differ)\n";
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        utils::EnableFastIO();
+        
+        if (argc < 3) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        
+        ValidateOptions options;
+        options.actual_file = argv[1];
+        options.expected_file = argv[2];
+        
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--max-mismatches" && i + 1 < argc) {
+                options.max_report = std::stoull(argv[++i]);
+            } else if (arg == "--stop") {
+                options.stop = true;
+            } else if (arg == "--ignore" && i + 1 < argc) {
+                for (auto name : utils::SplitCSVLine(argv[++i])) {
+                    options.ignore.emplace(name);
+                }
+            } else if (arg == "--mbo" && i + 1 < argc) {
+                options.mbo_file = argv[++i];
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        
+        return Validate(options);
+    
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
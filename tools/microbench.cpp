@@ -0,0 +1,434 @@
+#include "line_reader.h"
+#include "orderbook.h"
+#include "records.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void PrintUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]\n";
+    std::cout << "\n";
+    std::cout << "Description:\n";
+    std::cout << "  Microbenchmarks for the parsing, book and formatting hot paths. Each benchmark\n";
+    std::cout << "  is calibrated, warmed up and repeated; the summary is per operation.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --repetitions N   Timed repetitions per benchmark (default: 15)\n";
+    std::cout << "  --min-time-ms N   Minimum duration of one repetition (default: 20)\n";
+    std::cout << "  --warmup N        Untimed repetitions before measuring (default: 3)\n";
+    std::cout << "  --filter TEXT     Run only benchmarks whose name contains TEXT\n";
+    std::cout << "  --input FILE      Use the lines of an MBO CSV file for the parsing benchmarks\n";
+    std::cout << "                    (default: generated lines)\n";
+    std::cout << "  --json FILE       Also write the results as JSON\n";
+}
+
+/**
+ * Keep a value alive without letting the compiler see how it is used
+ */
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct BenchConfig {
+    uint64_t repetitions{15};
+    uint64_t min_time_ns{20 * 1000000ULL};
+    uint64_t warmup{3};
+    std::string filter;
+    std::string input_file;
+    std::string json_file;
+};
+
+/**
+ * One benchmark: `run` performs `ops_per_run` operations of the measured kind
+ */
+struct Benchmark {
+    std::string name;
+    uint64_t ops_per_run;
+    std::function<void()> run;
+};
+
+struct BenchResult {
+    std::string name;
+    uint64_t ops_per_repetition;
+    std::vector<double> ns_per_op;   // One entry per repetition, sorted
+    double mean;
+    double stddev;
+    
+    double Min() const { return ns_per_op.front(); }
+    double Max() const { return ns_per_op.back(); }
+    double Median() const {
+        size_t n = ns_per_op.size();
+        return n % 2 == 1 ? ns_per_op[n / 2] : (ns_per_op[n / 2 - 1] + ns_per_op[n / 2]) / 2.0;
+    }
+};
+
+uint64_t TimeRuns(const Benchmark& benchmark, uint64_t runs) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (uint64_t run = 0; run < runs; ++run) {
+        benchmark.run();
+    }
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count());
+}
+
+/**
+ * Size a repetition to at least min_time_ns, warm up, then time every repetition
+ */
+BenchResult Measure(const Benchmark& benchmark, const BenchConfig& config) {
+    uint64_t runs = 1;
+    while (true) {
+        uint64_t elapsed = TimeRuns(benchmark, runs);
+        if (elapsed >= config.min_time_ns) {
+            break;
+        }
+        // Aim 20% past the target so the next probe usually suffices
+        double scale = elapsed > 0 ? 1.2 * static_cast<double>(config.min_time_ns) / static_cast<double>(elapsed) : 10.0;
+        runs = std::max(runs + 1, static_cast<uint64_t>(static_cast<double>(runs) * std::min(scale, 10.0)));
+    }
+    
+    for (uint64_t i = 0; i < config.warmup; ++i) {
+        TimeRuns(benchmark, runs);
+    }
+    
+    BenchResult result;
+    result.name = benchmark.name;
+    result.ops_per_repetition = runs * benchmark.ops_per_run;
+    for (uint64_t i = 0; i < config.repetitions; ++i) {
+        uint64_t elapsed = TimeRuns(benchmark, runs);
+        result.ns_per_op.push_back(static_cast<double>(elapsed) / static_cast<double>(result.ops_per_repetition));
+    }
+    std::sort(result.ns_per_op.begin(), result.ns_per_op.end());
+    
+    double sum = 0.0;
+    for (double value : result.ns_per_op) {
+        sum += value;
+    }
+    result.mean = sum / static_cast<double>(result.ns_per_op.size());
+    double variance = 0.0;
+    for (double value : result.ns_per_op) {
+        variance += (value - result.mean) * (value - result.mean);
+    }
+    result.stddev = result.ns_per_op.size() > 1 ? std::sqrt(variance / static_cast<double>(result.ns_per_op.size() - 1)) : 0.0;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Workloads (fixed seeds, so every run measures the same inputs)
+// ---------------------------------------------------------------------------
+
+constexpr Price kTick = 10000000;            // 0.01 in 1e-9 units
+constexpr Price kMidPrice = 5510000000;      // 5.51
+
+std::vector<std::string> GenerateMBOLines(size_t count) {
+    std::mt19937_64 rng(42);
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    const char actions[] = {ACTION_ADD, ACTION_ADD, ACTION_CANCEL, ACTION_MODIFY, ACTION_TRADE};
+    char buffer[256];
+    for (size_t i = 0; i < count; ++i) {
+        char side = (rng() & 1) ? BID_SIDE : ASK_SIDE;
+        Price offset = static_cast<Price>(1 + rng() % 20) * kTick;
+        Price price = side == BID_SIDE ? kMidPrice - offset : kMidPrice + offset;
+        std::snprintf(buffer, sizeof(buffer),
+                      "2025-07-17T08:05:03.%09lluZ,2025-07-17T08:05:03.%09lluZ,160,2,1108,%c,%c,%s,%u,0,%llu,130,%u,%u,ARL",
+                      static_cast<unsigned long long>(360842448 + i * 1000), static_cast<unsigned long long>(360677248 + i * 1000),
+                      actions[rng() % 5], side, utils::FormatPrice(price).c_str(), static_cast<unsigned>(1 + rng() % 500),
+                      static_cast<unsigned long long>(800000 + rng() % 100000), static_cast<unsigned>(rng() % 200000),
+                      static_cast<unsigned>(851012 + i));
+        lines.emplace_back(buffer);
+    }
+    return lines;
+}
+
+std::vector<std::string> LoadMBOLines(const std::string& filename) {
+    std::vector<std::string> lines;
+    LineReader input(filename);
+    std::string_view line;
+    if (!input.ReadLine(line)) {
+        throw std::runtime_error("Input file is empty: " + filename);
+    }
+    while (input.ReadLine(line)) {
+        lines.emplace_back(line);
+    }
+    if (lines.empty()) {
+        throw std::runtime_error("No records in " + filename);
+    }
+    return lines;
+}
+
+/**
+ * Field of a CSV line by index (for pulling price strings out of the input lines)
+ */
+std::string_view Field(std::string_view line, size_t index) {
+    std::vector<std::string_view> fields = utils::SplitCSVLine(line);
+    return index < fields.size() ? fields[index] : std::string_view();
+}
+
+MBORecord MakeRecord(char action, char side, Price price, Size size, OrderID order_id) {
+    MBORecord record;
+    record.rtype = 160;
+    record.publisher_id = 2;
+    record.instrument_id = 1108;
+    record.action = action;
+    record.side = side;
+    record.price = price;
+    record.size = size;
+    record.channel_id = 0;
+    record.order_id = order_id;
+    record.flags = 130;
+    record.ts_in_delta = 0;
+    record.sequence = 0;
+    return record;
+}
+
+/**
+ * Add / cancel / modify sequence with the given percentages; cancels and
+ * modifies always target live orders, and half of the modifies move price
+ */
+std::vector<MBORecord> GenerateBookOps(size_t count, unsigned add_pct, unsigned cancel_pct, uint64_t seed) {
+    struct LiveOrder {
+        OrderID id;
+        char side;
+        Price price;
+    };
+    std::mt19937_64 rng(seed);
+    std::vector<MBORecord> records;
+    std::vector<LiveOrder> live;
+    records.reserve(count);
+    OrderID next_id = 1;
+    
+    auto random_price = [&rng](char side) {
+        Price offset = static_cast<Price>(1 + rng() % 50) * kTick;
+        return side == BID_SIDE ? kMidPrice - offset : kMidPrice + offset;
+    };
+    
+    while (records.size() < count) {
+        unsigned roll = static_cast<unsigned>(rng() % 100);
+        Size size = static_cast<Size>(1 + rng() % 500);
+        if (live.empty() || roll < add_pct) {
+            char side = (rng() & 1) ? BID_SIDE : ASK_SIDE;
+            Price price = random_price(side);
+            records.push_back(MakeRecord(ACTION_ADD, side, price, size, next_id));
+            live.push_back({next_id++, side, price});
+            continue;
+        }
+        size_t index = rng() % live.size();
+        LiveOrder& order = live[index];
+        if (roll < add_pct + cancel_pct) {
+            records.push_back(MakeRecord(ACTION_CANCEL, order.side, order.price, size, order.id));
+            order = live.back();
+            live.pop_back();
+        } else {
+            if (rng() & 1) {
+                order.price = random_price(order.side);
+            }
+            records.push_back(MakeRecord(ACTION_MODIFY, order.side, order.price, size, order.id));
+        }
+    }
+    return records;
+}
+
+/**
+ * Book with `levels_per_side` levels on each side and a few orders per level
+ */
+void FillBook(OrderBook& book, size_t levels_per_side) {
+    OrderID next_id = 1;
+    for (size_t level = 0; level < levels_per_side; ++level) {
+        Price offset = static_cast<Price>(level + 1) * kTick;
+        for (int order = 0; order < 3; ++order) {
+            book.Apply(MakeRecord(ACTION_ADD, BID_SIDE, kMidPrice - offset, 100, next_id++));
+            book.Apply(MakeRecord(ACTION_ADD, ASK_SIDE, kMidPrice + offset, 100, next_id++));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Reporting
+// ---------------------------------------------------------------------------
+
+void PrintResults(const std::vector<BenchResult>& results, const BenchConfig& config) {
+    std::cout << "Repetitions: " << config.repetitions << " (after " << config.warmup << " warm-up), >= "
+              << config.min_time_ns / 1000000 << " ms each\n";
+    std::cout << std::left << std::setw(26) << "benchmark" << std::right << std::setw(12) << "median ns" << std::setw(10)
+              << "min" << std::setw(10) << "max" << std::setw(9) << "cv %" << std::setw(14) << "Mops/s" << "\n";
+    std::cout << std::fixed;
+    for (const auto& result : results) {
+        double cv = result.mean > 0 ? 100.0 * result.stddev / result.mean : 0.0;
+        std::cout << std::left << std::setw(26) << result.name << std::right << std::setprecision(2) << std::setw(12)
+                  << result.Median() << std::setw(10) << result.Min() << std::setw(10) << result.Max() << std::setprecision(1)
+                  << std::setw(9) << cv << std::setprecision(2) << std::setw(14) << 1000.0 / result.Median() << "\n";
+    }
+    std::cout << std::defaultfloat;
+}
+
+void WriteJson(const std::vector<BenchResult>& results, const BenchConfig& config) {
+    std::ofstream out(config.json_file);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open JSON output file: " + config.json_file);
+    }
+    
+    out << std::setprecision(6);
+    out << "{\n  \"config\": {\"repetitions\": " << config.repetitions << ", \"warmup\": " << config.warmup
+        << ", \"min_time_ns\": " << config.min_time_ns << ", \"input\": \""
+        << (config.input_file.empty() ? "generated" : config.input_file) << "\"},\n";
+    out << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"ops_per_repetition\": "
+            << result.ops_per_repetition << ", \"ns_per_op\": {\"median\": " << result.Median() << ", \"mean\": "
+            << result.mean << ", \"stddev\": " << result.stddev << ", \"min\": " << result.Min() << ", \"max\": "
+            << result.Max() << "}, \"samples\": [";
+        for (size_t j = 0; j < result.ns_per_op.size(); ++j) {
+            out << (j == 0 ? "" : ", ") << result.ns_per_op[j];
+        }
+        out << "]}";
+    }
+    out << (results.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    
+    if (!out) {
+        throw std::runtime_error("Failed to write JSON output file: " + config.json_file);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        BenchConfig config;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--repetitions" && i + 1 < argc) {
+                config.repetitions = std::stoull(argv[++i]);
+            } else if (arg == "--min-time-ms" && i + 1 < argc) {
+                config.min_time_ns = std::stoull(argv[++i]) * 1000000ULL;
+            } else if (arg == "--warmup" && i + 1 < argc) {
+                config.warmup = std::stoull(argv[++i]);
+            } else if (arg == "--filter" && i + 1 < argc) {
+                config.filter = argv[++i];
+            } else if (arg == "--input" && i + 1 < argc) {
+                config.input_file = argv[++i];
+            } else if (arg == "--json" && i + 1 < argc) {
+                config.json_file = argv[++i];
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        if (config.repetitions == 0) {
+            throw std::invalid_argument("--repetitions must be positive");
+        }
+        
+        // Inputs
+        std::vector<std::string> lines = config.input_file.empty() ? GenerateMBOLines(4096) : LoadMBOLines(config.input_file);
+        std::vector<std::string> price_strings;
+        for (const auto& line : lines) {
+            std::string_view price = Field(line, 7);
+            if (!price.empty()) {
+                price_strings.emplace_back(price);
+            }
+        }
+        if (price_strings.empty()) {
+            throw std::runtime_error("No prices in the input lines");
+        }
+        std::vector<Price> prices;
+        for (const auto& price : price_strings) {
+            prices.push_back(utils::ParsePrice(price));
+        }
+        
+        struct ApplyMix {
+            const char* name;
+            unsigned add_pct;
+            unsigned cancel_pct;
+        };
+        const ApplyMix mixes[] = {
+            {"apply/add_cancel", 50, 50},
+            {"apply/add_heavy", 70, 20},
+            {"apply/modify_heavy", 30, 20},
+        };
+        std::vector<std::vector<MBORecord>> mix_records;
+        for (const auto& mix : mixes) {
+            mix_records.push_back(GenerateBookOps(20000, mix.add_pct, mix.cancel_pct, 7));
+        }
+        
+        OrderBook apply_book;
+        OrderBook deep_book;
+        FillBook(deep_book, 50);
+        MBPRecord mbp_record = MBPRecord::FromOrderBook(MakeRecord(ACTION_ADD, BID_SIDE, kMidPrice - kTick, 100, 1),
+                                                        deep_book.GetTopBids(), deep_book.GetTopAsks());
+        mbp_record.ts_recv = "2025-07-17T08:05:03.360842448Z";
+        mbp_record.ts_event = "2025-07-17T08:05:03.360677248Z";
+        mbp_record.symbol = "ARL";
+        
+        std::vector<Benchmark> benchmarks;
+        benchmarks.push_back({"SplitCSVLine", lines.size(), [&lines] {
+            for (const auto& line : lines) {
+                auto fields = utils::SplitCSVLine(line);
+                DoNotOptimize(fields);
+            }
+        }});
+        benchmarks.push_back({"ParsePrice", price_strings.size(), [&price_strings] {
+            for (const auto& price : price_strings) {
+                Price parsed = utils::ParsePrice(price);
+                DoNotOptimize(parsed);
+            }
+        }});
+        benchmarks.push_back({"FormatPrice", prices.size(), [&prices] {
+            for (Price price : prices) {
+                std::string text = utils::FormatPrice(price);
+                DoNotOptimize(text);
+            }
+        }});
+        benchmarks.push_back({"MBORecord::Parse", lines.size(), [&lines] {
+            for (const auto& line : lines) {
+                MBORecord record = MBORecord::Parse(line);
+                DoNotOptimize(record);
+            }
+        }});
+        for (size_t i = 0; i < mix_records.size(); ++i) {
+            // Per record, including the share of one Clear() per pass
+            benchmarks.push_back({mixes[i].name, mix_records[i].size(), [&apply_book, &records = mix_records[i]] {
+                apply_book.Clear();
+                for (const auto& record : records) {
+                    apply_book.Apply(record);
+                }
+                DoNotOptimize(apply_book);
+            }});
+        }
+        benchmarks.push_back({"GetTopBids", 1, [&deep_book] {
+            auto levels = deep_book.GetTopBids();
+            DoNotOptimize(levels);
+        }});
+        benchmarks.push_back({"MBPRecord::ToCSV", 1, [&mbp_record] {
+            std::string row = mbp_record.ToCSV();
+            DoNotOptimize(row);
+        }});
+        
+        std::vector<BenchResult> results;
+        for (const auto& benchmark : benchmarks) {
+            if (!config.filter.empty() && benchmark.name.find(config.filter) == std::string::npos) {
+                continue;
+            }
+            results.push_back(Measure(benchmark, config));
+        }
+        
+        PrintResults(results, config);
+        if (!config.json_file.empty()) {
+            WriteJson(results, config);
+            std::cout << "Results written to " << config.json_file << "\n";
+        }
+        return 0;
+    
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
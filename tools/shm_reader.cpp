@@ -0,0 +1,127 @@
+#include "shm_book.h"
+#include "utils.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+void PrintUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <name> [--instrument ID] [--watch N] [--interval D] [--bench N]\n";
+    std::cout << "\n";
+    std::cout << "Description:\n";
+    std::cout << "  Prints books published with --shm-publish NAME from shared memory.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << "  --instrument ID  Instrument to show (default: every published instrument)\n";
+    std::cout << "  --watch N        Poll and print the book on each of the next N updates\n";
+    std::cout << "  --interval D     Poll interval for --watch (default: 1ms)\n";
+    std::cout << "  --bench N        Time N consistent snapshot reads\n";
+}
+
+void PrintBook(const shm_book::BookSnapshot& book) {
+    std::cout << "Instrument " << book.instrument_id << "  update " << book.update_count
+              << "  ts_event " << utils::FormatTimestamp(book.ts_event)
+              << "  last " << book.action << " " << book.side << " " << utils::FormatPrice(book.price)
+              << " x " << book.size << "  seq " << book.sequence << "\n";
+    std::cout << "  " << std::setw(8) << "bid_ct" << std::setw(10) << "bid_sz" << std::setw(14) << "bid_px"
+              << std::setw(14) << "ask_px" << std::setw(10) << "ask_sz" << std::setw(8) << "ask_ct" << "\n";
+    for (int i = 0; i < MBP_LEVELS; ++i) {
+        const CompactPriceLevel& bid = book.bids[i];
+        const CompactPriceLevel& ask = book.asks[i];
+        if (bid.IsEmpty() && ask.IsEmpty()) {
+            break;
+        }
+        std::cout << "  " << std::setw(8) << bid.count << std::setw(10) << bid.size
+                  << std::setw(14) << (bid.IsEmpty() ? "" : utils::FormatPrice(bid.price))
+                  << std::setw(14) << (ask.IsEmpty() ? "" : utils::FormatPrice(ask.price))
+                  << std::setw(10) << ask.size << std::setw(8) << ask.count << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 2) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+
+        std::string name = argv[1];
+        bool all_instruments = true;
+        uint32_t instrument_id = 0;
+        uint64_t watch_updates = 0;
+        uint64_t interval_ns = 1000000;
+        uint64_t bench_reads = 0;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--instrument" && i + 1 < argc) {
+                instrument_id = static_cast<uint32_t>(std::stoul(argv[++i]));
+                all_instruments = false;
+            } else if (arg == "--watch" && i + 1 < argc) {
+                watch_updates = std::stoull(argv[++i]);
+            } else if (arg == "--interval" && i + 1 < argc) {
+                interval_ns = utils::ParseDuration(argv[++i]);
+            } else if (arg == "--bench" && i + 1 < argc) {
+                bench_reads = std::stoull(argv[++i]);
+            } else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+
+        ShmBookReader reader(name);
+        auto instruments = reader.Instruments();
+        if (all_instruments) {
+            if (instruments.empty()) {
+                std::cout << "No instruments published yet\n";
+                return 0;
+            }
+            if (watch_updates > 0 || bench_reads > 0) {
+                instrument_id = instruments.front();
+            }
+        }
+
+        shm_book::BookSnapshot book;
+
+        if (bench_reads > 0) {
+            auto start_time = std::chrono::steady_clock::now();
+            uint64_t checksum = 0;
+            for (uint64_t i = 0; i < bench_reads; ++i) {
+                reader.Read(instrument_id, book);
+                checksum += book.update_count;
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time);
+            std::cout << "Reads: " << bench_reads << "  mean " << elapsed.count() / bench_reads
+                      << "ns per consistent snapshot (checksum " << checksum << ")\n";
+            return 0;
+        }
+
+        if (watch_updates > 0) {
+            uint64_t seen = reader.UpdateCount(instrument_id);
+            for (uint64_t printed = 0; printed < watch_updates;) {
+                uint64_t current = reader.UpdateCount(instrument_id);
+                if (current != seen && reader.Read(instrument_id, book)) {
+                    seen = book.update_count;
+                    PrintBook(book);
+                    ++printed;
+                } else {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(interval_ns));
+                }
+            }
+            return 0;
+        }
+
+        for (uint32_t id : instruments) {
+            if ((all_instruments || id == instrument_id) && reader.Read(id, book)) {
+                PrintBook(book);
+            }
+        }
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}